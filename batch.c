@@ -0,0 +1,180 @@
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "dungeon.h"
+
+#define OUTCOME_WIN 0
+#define OUTCOME_LOSS 1
+#define OUTCOME_UNFINISHED 2
+
+struct Game_Outcome {
+    int outcome;
+    long turns;
+    int monsters_spawned_by_type[NUMBER_OF_MONSTER_TYPES];
+    int monsters_killed_by_type[NUMBER_OF_MONSTER_TYPES];
+    int player_killed_by;
+};
+
+struct Batch_Work {
+    Batch_Config config;
+    struct Game_Outcome * outcomes;
+    int next_game;
+    pthread_mutex_t lock;
+};
+
+// Spreads consecutive game indexes over the seed space (splitmix64) so that
+// neighboring games do not start from neighboring seeds.
+uint64_t get_game_seed(uint64_t seed, int game) {
+    uint64_t z = seed + ((uint64_t) (game + 1) * 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+void play_batch_game(Batch_Config config, int game, struct Game_Outcome * outcome) {
+    Dungeon * d = create_new_dungeon();
+    d->verbose = 0;
+    set_dungeon_size(d, config.width, config.height);
+    d->number_of_rooms = config.number_of_rooms;
+    d->number_of_monsters = config.number_of_monsters;
+    d->max_turns = config.max_turns;
+    d->use_heap_pathing = config.use_heap_pathing;
+    d->check_behavior = config.check_behavior;
+    d->turn_threads = config.turn_threads;
+    d->path_threads = config.path_threads;
+    d->player = config.player;
+    seed_random_streams(d, get_game_seed(config.seed, game));
+    if (config.snapshot != NULL) {
+        restore_snapshot(d, config.snapshot);
+        seed_random_streams(d, get_game_seed(config.seed, game));
+    }
+    else if (config.pack != NULL) {
+        load_board_from_pack(d, config.pack, game % config.pack->number_of_entries);
+    }
+    else if (config.load) {
+        make_rlg_directory(d);
+        load_board(d);
+        // Each game places a random player from its own seed, so only games
+        // with a fixed player can share a cache.
+        d->cache_distances = config.cache_distances && (d->player.x || d->player.y);
+    }
+    else {
+        generate_dungeon(d);
+    }
+    if (config.snapshot == NULL) {
+        start_game(d);
+    }
+    while (!game_is_over(d)) {
+        play_turn(d);
+    }
+
+    if (!d->player_is_alive) {
+        outcome->outcome = OUTCOME_LOSS;
+    }
+    else if (!d->number_of_monsters) {
+        outcome->outcome = OUTCOME_WIN;
+    }
+    else {
+        outcome->outcome = OUTCOME_UNFINISHED;
+    }
+    outcome->turns = d->turns;
+    memcpy(outcome->monsters_spawned_by_type, d->monsters_spawned_by_type, sizeof(outcome->monsters_spawned_by_type));
+    memcpy(outcome->monsters_killed_by_type, d->monsters_killed_by_type, sizeof(outcome->monsters_killed_by_type));
+    outcome->player_killed_by = d->player_killed_by;
+    free_dungeon(d);
+}
+
+void * run_batch_worker(void * arg) {
+    struct Batch_Work * work = arg;
+    while (1) {
+        pthread_mutex_lock(&work->lock);
+        int game = work->next_game;
+        work->next_game ++;
+        pthread_mutex_unlock(&work->lock);
+        if (game >= work->config.games) {
+            break;
+        }
+        play_batch_game(work->config, game, &work->outcomes[game]);
+    }
+    return NULL;
+}
+
+// Plays every game of the batch on a pool of threads. Games only share the
+// read-only config, and outcomes are tallied in game order afterwards, so the
+// result does not depend on the number of threads.
+Batch_Result run_batch(Batch_Config config) {
+    struct Batch_Work work;
+    work.config = config;
+    work.outcomes = malloc(sizeof(struct Game_Outcome) * config.games);
+    work.next_game = 0;
+    pthread_mutex_init(&work.lock, NULL);
+
+    struct timespec start;
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    pthread_t * threads = malloc(sizeof(pthread_t) * config.threads);
+    for (int i = 0; i < config.threads; i++) {
+        if (pthread_create(&threads[i], NULL, run_batch_worker, &work)) {
+            printf("Cannot start batch thread %d\n", i);
+            exit(1);
+        }
+    }
+    for (int i = 0; i < config.threads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    Batch_Result result;
+    memset(&result, 0, sizeof(result));
+    result.games = config.games;
+    result.threads = config.threads;
+    result.seconds = (end.tv_sec - start.tv_sec) + ((end.tv_nsec - start.tv_nsec) / 1e9);
+    for (int i = 0; i < config.games; i++) {
+        struct Game_Outcome outcome = work.outcomes[i];
+        if (outcome.outcome == OUTCOME_WIN) {
+            result.wins ++;
+        }
+        else if (outcome.outcome == OUTCOME_LOSS) {
+            result.losses ++;
+        }
+        else {
+            result.unfinished ++;
+        }
+        result.total_turns += outcome.turns;
+        if (i == 0 || outcome.turns < result.min_turns) {
+            result.min_turns = outcome.turns;
+        }
+        if (outcome.turns > result.max_turns) {
+            result.max_turns = outcome.turns;
+        }
+        for (int type = 0; type < NUMBER_OF_MONSTER_TYPES; type++) {
+            result.monsters_spawned_by_type[type] += outcome.monsters_spawned_by_type[type];
+            result.monsters_killed_by_type[type] += outcome.monsters_killed_by_type[type];
+        }
+        if (outcome.player_killed_by != -1) {
+            result.player_kills_by_type[outcome.player_killed_by] ++;
+        }
+    }
+
+    pthread_mutex_destroy(&work.lock);
+    free(threads);
+    free(work.outcomes);
+    return result;
+}
+
+void print_batch_result(Batch_Result result) {
+    printf("Played %d games on %d threads in %.2fs (%.1f games/s)\n",
+            result.games, result.threads, result.seconds, result.games / result.seconds);
+    printf("Wins: %d, Losses: %d, Unfinished: %d\n", result.wins, result.losses, result.unfinished);
+    printf("Turns: mean %.1f, min %ld, max %ld\n",
+            (double) result.total_turns / result.games, result.min_turns, result.max_turns);
+    printf("type  spawned   killed  killed player\n");
+    for (int type = 0; type < NUMBER_OF_MONSTER_TYPES; type++) {
+        printf("%4x %8ld %8ld %14ld\n", type, result.monsters_spawned_by_type[type],
+                result.monsters_killed_by_type[type], result.player_kills_by_type[type]);
+    }
+}
@@ -0,0 +1,470 @@
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <limits.h>
+
+#include "dungeon.h"
+
+#define BENCH_SEED 327
+#define BENCH_MONSTERS 1
+#define QUEUE_BENCH_SIZE 1024
+#define MOVES_PER_BLOCK 64
+#define MAX_RESULTS 64
+// A million cells, the map the path pool is scaled on.
+#define SCALING_MAP_SIZE 1024
+#define SCALING_ITERATIONS 10
+
+enum Output_Format {
+    FORMAT_TEXT,
+    FORMAT_JSON,
+    FORMAT_CSV
+};
+
+struct Bench_Result {
+    char name[32];
+    char unit[16];
+    long operations;
+    double ns_per_op;
+    double allocations_per_op;
+    double units_per_second;
+};
+
+struct Bench_Result results[MAX_RESULTS];
+int NUMBER_OF_RESULTS = 0;
+long ALLOCATIONS = 0;
+FILE * report;
+
+void * __real_malloc(size_t size);
+void * __real_calloc(size_t count, size_t size);
+void * __real_realloc(void * pointer, size_t size);
+
+void * __wrap_malloc(size_t size) {
+    ALLOCATIONS ++;
+    return __real_malloc(size);
+}
+
+void * __wrap_calloc(size_t count, size_t size) {
+    ALLOCATIONS ++;
+    return __real_calloc(count, size);
+}
+
+void * __wrap_realloc(void * pointer, size_t size) {
+    ALLOCATIONS ++;
+    return __real_realloc(pointer, size);
+}
+
+uint64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t) ts.tv_sec * 1000000000ULL) + ts.tv_nsec;
+}
+
+void record_result(char * name, char * unit, long operations, uint64_t elapsed_ns, long allocations, double units_per_op) {
+    struct Bench_Result * r = &results[NUMBER_OF_RESULTS];
+    NUMBER_OF_RESULTS ++;
+    snprintf(r->name, sizeof(r->name), "%s", name);
+    snprintf(r->unit, sizeof(r->unit), "%s", unit);
+    r->operations = operations;
+    r->ns_per_op = (double) elapsed_ns / operations;
+    r->allocations_per_op = (double) allocations / operations;
+    r->units_per_second = units_per_op * operations * 1e9 / elapsed_ns;
+}
+
+void bench_generation(Dungeon * d, long iterations) {
+    seed_random_streams(d, BENCH_SEED);
+    long allocations = ALLOCATIONS;
+    uint64_t start = now_ns();
+    for (long i = 0; i < iterations; i++) {
+        initialize_board(d);
+        dig_rooms(d, d->number_of_rooms);
+        dig_cooridors(d);
+    }
+    uint64_t elapsed = now_ns() - start;
+    record_result("generate", "dungeons", iterations, elapsed, ALLOCATIONS - allocations, 1);
+}
+
+// Builds one fixed dungeon with the player and a single monster in it, the
+// state every benchmark after generation starts from.
+void set_up_game(Dungeon * d) {
+    seed_random_streams(d, BENCH_SEED);
+    initialize_board(d);
+    dig_rooms(d, d->number_of_rooms);
+    dig_cooridors(d);
+    d->number_of_monsters = BENCH_MONSTERS;
+    start_game(d);
+    // The heap is made on first use; make it here so the heap benchmarks
+    // do not count it.
+    make_distance_queue(d);
+}
+
+void copy_board(Dungeon * d, struct Board * to, struct Board * from) {
+    int cells = d->width * d->height;
+    memcpy(to->hardness, from->hardness, sizeof(uint8_t) * cells);
+    memcpy(to->type, from->type, sizeof(uint8_t) * cells);
+    memcpy(to->tunneling_distance, from->tunneling_distance, sizeof(uint32_t) * cells);
+    memcpy(to->non_tunneling_distance, from->non_tunneling_distance, sizeof(uint32_t) * cells);
+    memcpy(to->monster, from->monster, sizeof(Monster_Handle) * cells);
+}
+
+// Copies every plane of the board into a new board, so a benchmark can put
+// the board back after changing it.
+struct Board make_board_copy(Dungeon * d) {
+    int cells = d->width * d->height;
+    struct Board copy;
+    copy.hardness = malloc(sizeof(uint8_t) * cells);
+    copy.type = malloc(sizeof(uint8_t) * cells);
+    copy.tunneling_distance = malloc(sizeof(uint32_t) * cells);
+    copy.non_tunneling_distance = malloc(sizeof(uint32_t) * cells);
+    copy.monster = malloc(sizeof(Monster_Handle) * cells);
+    copy_board(d, &copy, &d->board);
+    return copy;
+}
+
+void free_board_copy(struct Board * copy) {
+    free(copy->hardness);
+    free(copy->type);
+    free(copy->tunneling_distance);
+    free(copy->non_tunneling_distance);
+    free(copy->monster);
+}
+
+void bench_distance_map(Dungeon * d, char * name, void (*set_distances)(Dungeon *), long iterations) {
+    long allocations = ALLOCATIONS;
+    uint64_t start = now_ns();
+    for (long i = 0; i < iterations; i++) {
+        set_distances(d);
+    }
+    uint64_t elapsed = now_ns() - start;
+    record_result(name, "cells", iterations, elapsed, ALLOCATIONS - allocations, d->width * d->height);
+}
+
+// Times both distance maps on the path pool of a generated million-cell
+// dungeon, from 1 thread up to max_threads, doubling. Every map has to match
+// the one computed on a single thread without the pool.
+void bench_path_scaling(int max_threads, long iterations) {
+    Dungeon * d = create_new_dungeon();
+    d->verbose = 0;
+    set_dungeon_size(d, SCALING_MAP_SIZE, SCALING_MAP_SIZE);
+    d->number_of_rooms = get_max_number_of_rooms(d);
+    seed_random_streams(d, BENCH_SEED);
+    generate_dungeon(d);
+    d->number_of_monsters = BENCH_MONSTERS;
+    start_game(d);
+    struct Board expected = make_board_copy(d);
+    int cells = d->width * d->height;
+    bench_distance_map(d, "tunneling_1m_buckets", set_tunneling_distance_with_buckets, iterations);
+    bench_distance_map(d, "non_tunneling_1m_bfs", set_non_tunneling_distance_with_bfs, iterations);
+    for (int threads = 1; threads <= max_threads; threads *= 2) {
+        if (threads * 2 > max_threads) {
+            threads = max_threads;
+        }
+        d->path_threads = threads;
+        char name[32];
+        snprintf(name, sizeof(name), "tunneling_1m_%d_threads", threads);
+        bench_distance_map(d, name, set_tunneling_distance_in_parallel, iterations);
+        snprintf(name, sizeof(name), "non_tunneling_1m_%d_threads", threads);
+        bench_distance_map(d, name, set_non_tunneling_distance_in_parallel, iterations);
+        if (memcmp(d->board.tunneling_distance, expected.tunneling_distance, sizeof(uint32_t) * cells) != 0 ||
+                memcmp(d->board.non_tunneling_distance, expected.non_tunneling_distance, sizeof(uint32_t) * cells) != 0) {
+            fprintf(report, "Distance maps on %d path threads differ from the sequential ones\n", threads);
+            exit(1);
+        }
+        // The pool is made for the thread count it was first used with.
+        free_path_pool(d->path_pool);
+        d->path_pool = NULL;
+    }
+    free_board_copy(&expected);
+    free_dungeon(d);
+}
+
+void bench_queue(Dungeon * d, long rounds) {
+    Queue * q = create_new_queue(d->width, d->height);
+    Rng rng;
+    seed_rng(&rng, BENCH_SEED, 0);
+    struct Coordinate coords[QUEUE_BENCH_SIZE];
+    for (int i = 0; i < QUEUE_BENCH_SIZE; i++) {
+        // 7919 shares no factor with the board size, so these are distinct.
+        int index = (i * 7919) % (d->width * d->height);
+        coords[i].x = index % d->width;
+        coords[i].y = index / d->width;
+    }
+
+    long allocations = ALLOCATIONS;
+    uint64_t start = now_ns();
+    for (long r = 0; r < rounds; r++) {
+        for (int i = 0; i < QUEUE_BENCH_SIZE; i++) {
+            insert_with_priority(q, coords[i], random_below(&rng, 100000));
+        }
+        for (int i = 0; i < QUEUE_BENCH_SIZE; i++) {
+            extract_min(q);
+        }
+    }
+    uint64_t elapsed = now_ns() - start;
+    record_result("queue_insert_extract", "ops", rounds * QUEUE_BENCH_SIZE * 2, elapsed, ALLOCATIONS - allocations, 1);
+
+    uint64_t decrease_elapsed = 0;
+    allocations = ALLOCATIONS;
+    for (long r = 0; r < rounds; r++) {
+        for (int i = 0; i < QUEUE_BENCH_SIZE; i++) {
+            insert_with_priority(q, coords[i], 100000 + random_below(&rng, 100000));
+        }
+        start = now_ns();
+        for (int i = 0; i < QUEUE_BENCH_SIZE; i++) {
+            decrease_priority(q, coords[i], random_below(&rng, 100000));
+        }
+        decrease_elapsed += now_ns() - start;
+        clear_queue(q);
+    }
+    record_result("queue_decrease_priority", "ops", rounds * QUEUE_BENCH_SIZE, decrease_elapsed, ALLOCATIONS - allocations, 1);
+    free_queue(q);
+}
+
+// Steps every open cell down the tunneling map with the plain loop, the
+// vector version and the batched version, exiting if they ever disagree.
+void bench_lowest_neighbors(Dungeon * d, long iterations) {
+    int count = d->number_of_placeable_areas;
+    int * indexes = malloc(sizeof(int) * count);
+    int * expected = malloc(sizeof(int) * count);
+    int * lowest = malloc(sizeof(int) * count);
+    for (int i = 0; i < count; i++) {
+        indexes[i] = cell_index(d, d->placeable_areas[i].x, d->placeable_areas[i].y);
+        expected[i] = get_lowest_neighbor_in_order(d, d->board.tunneling_distance, indexes[i]);
+    }
+
+    uint64_t start = now_ns();
+    for (long n = 0; n < iterations; n++) {
+        for (int i = 0; i < count; i++) {
+            lowest[i] = get_lowest_neighbor_in_order(d, d->board.tunneling_distance, indexes[i]);
+        }
+    }
+    record_result("lowest_neighbor_loop", "cells", iterations * count, now_ns() - start, 0, 1);
+
+    start = now_ns();
+    for (long n = 0; n < iterations; n++) {
+        for (int i = 0; i < count; i++) {
+            lowest[i] = get_lowest_neighbor(d, d->board.tunneling_distance, indexes[i]);
+        }
+    }
+    record_result("lowest_neighbor", "cells", iterations * count, now_ns() - start, 0, 1);
+    if (memcmp(lowest, expected, sizeof(int) * count) != 0) {
+        fprintf(report, "get_lowest_neighbor disagrees with the plain loop\n");
+        exit(1);
+    }
+
+    start = now_ns();
+    for (long n = 0; n < iterations; n++) {
+        get_lowest_neighbors(d, d->board.tunneling_distance, indexes, lowest, count);
+    }
+    record_result("lowest_neighbors_batch", "cells", iterations * count, now_ns() - start, 0, 1);
+    if (memcmp(lowest, expected, sizeof(int) * count) != 0) {
+        fprintf(report, "get_lowest_neighbors disagrees with the plain loop\n");
+        exit(1);
+    }
+    free(indexes);
+    free(expected);
+    free(lowest);
+}
+
+// Moves the monster in blocks, putting the board back between blocks so
+// tunneling monsters keep finding the same rock to dig through.
+void bench_monster_moves(Dungeon * d, int type, long blocks) {
+    struct Board saved_board = make_board_copy(d);
+    struct Monster original_monster = d->monsters[0];
+    struct Monster saved_monster = original_monster;
+    saved_monster.decimal_type = type;
+    char name[32];
+    snprintf(name, sizeof(name), "move_monster_type_%x", type);
+
+    Rng rng;
+    seed_rng(&rng, BENCH_SEED, STREAM_MOVEMENT);
+    uint64_t elapsed = 0;
+    long allocations = 0;
+    for (long b = 0; b < blocks; b++) {
+        copy_board(d, &d->board, &saved_board);
+        d->monsters[0] = saved_monster;
+        d->player_is_alive = 1;
+        long block_allocations = ALLOCATIONS;
+        uint64_t start = now_ns();
+        for (int i = 0; i < MOVES_PER_BLOCK; i++) {
+            move_monster_at_index(d, 0, &rng);
+        }
+        elapsed += now_ns() - start;
+        allocations += ALLOCATIONS - block_allocations;
+    }
+    record_result(name, "moves", blocks * MOVES_PER_BLOCK, elapsed, allocations, 1);
+
+    copy_board(d, &d->board, &saved_board);
+    free_board_copy(&saved_board);
+    d->monsters[0] = original_monster;
+    d->player_is_alive = 1;
+}
+
+void bench_print_board(Dungeon * d, char * name, int incremental, long iterations) {
+    d->incremental_rendering = incremental;
+    d->frame_is_drawn = 0;
+    print_board(d);
+    long allocations = ALLOCATIONS;
+    uint64_t start = now_ns();
+    for (long i = 0; i < iterations; i++) {
+        print_board(d);
+    }
+    uint64_t elapsed = now_ns() - start;
+    record_result(name, "cells", iterations, elapsed, ALLOCATIONS - allocations, d->width * d->height);
+    d->incremental_rendering = 0;
+}
+
+// Saves the dungeon in a temporary directory and times loading it back.
+// The board is put back afterwards so later benchmarks see the same game.
+void bench_load(Dungeon * d, int version, long iterations) {
+    struct Board saved_board = make_board_copy(d);
+    struct Room * saved_rooms = d->rooms;
+    int saved_number_of_rooms = d->number_of_rooms;
+    char directory[] = "/tmp/bench_dungeon_XXXXXX";
+    if (mkdtemp(directory) == NULL) {
+        fprintf(report, "Cannot create a directory for the load benchmarks\n");
+        exit(1);
+    }
+    char * saved_directory = d->rlg_directory;
+    d->rlg_directory = malloc(strlen(directory) + 2);
+    sprintf(d->rlg_directory, "%s/", directory);
+    save_board(d, version);
+    char name[32];
+    snprintf(name, sizeof(name), "load_version_%d", version);
+
+    d->rooms = NULL;
+    long allocations = ALLOCATIONS;
+    uint64_t start = now_ns();
+    for (long i = 0; i < iterations; i++) {
+        load_board(d);
+    }
+    uint64_t elapsed = now_ns() - start;
+    record_result(name, "cells", iterations, elapsed, ALLOCATIONS - allocations, d->width * d->height);
+
+    char filepath[PATH_MAX];
+    get_dungeon_path(d, filepath, sizeof(filepath));
+    unlink(filepath);
+    rmdir(directory);
+    free(d->rlg_directory);
+    free(d->rooms);
+    d->rlg_directory = saved_directory;
+    d->rooms = saved_rooms;
+    d->number_of_rooms = saved_number_of_rooms;
+    copy_board(d, &d->board, &saved_board);
+    free_board_copy(&saved_board);
+}
+
+// Snapshots the game in a temporary file and times restoring it into a
+// second dungeon.
+void bench_restore_snapshot(Dungeon * d, long iterations) {
+    char path[] = "/tmp/bench_snapshot_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd == -1 || !save_snapshot(d, path)) {
+        fprintf(report, "Cannot create a snapshot for the restore benchmark\n");
+        exit(1);
+    }
+    close(fd);
+    Snapshot * snapshot = read_snapshot(path);
+    Dungeon * copy = create_new_dungeon();
+
+    long allocations = ALLOCATIONS;
+    uint64_t start = now_ns();
+    for (long i = 0; i < iterations; i++) {
+        restore_snapshot(copy, snapshot);
+    }
+    uint64_t elapsed = now_ns() - start;
+    record_result("restore_snapshot", "cells", iterations, elapsed, ALLOCATIONS - allocations, d->width * d->height);
+
+    free_dungeon(copy);
+    free_snapshot(snapshot);
+    unlink(path);
+}
+
+void print_results(enum Output_Format format) {
+    if (format == FORMAT_JSON) {
+        fprintf(report, "{\"seed\": %d, \"benchmarks\": [\n", BENCH_SEED);
+        for (int i = 0; i < NUMBER_OF_RESULTS; i++) {
+            struct Bench_Result r = results[i];
+            fprintf(report, "  {\"name\": \"%s\", \"operations\": %ld, \"ns_per_op\": %.1f, \"allocations_per_op\": %.3f, \"throughput\": %.1f, \"unit\": \"%s/s\"}%s\n",
+                    r.name, r.operations, r.ns_per_op, r.allocations_per_op, r.units_per_second, r.unit, i == NUMBER_OF_RESULTS - 1 ? "" : ",");
+        }
+        fprintf(report, "]}\n");
+    }
+    else if (format == FORMAT_CSV) {
+        fprintf(report, "name,operations,ns_per_op,allocations_per_op,throughput,unit\n");
+        for (int i = 0; i < NUMBER_OF_RESULTS; i++) {
+            struct Bench_Result r = results[i];
+            fprintf(report, "%s,%ld,%.1f,%.3f,%.1f,%s/s\n", r.name, r.operations, r.ns_per_op, r.allocations_per_op, r.units_per_second, r.unit);
+        }
+    }
+    else {
+        fprintf(report, "Seed: %d\n", BENCH_SEED);
+        fprintf(report, "%-26s %12s %14s %12s %16s\n", "benchmark", "operations", "ns/op", "allocs/op", "throughput");
+        for (int i = 0; i < NUMBER_OF_RESULTS; i++) {
+            struct Bench_Result r = results[i];
+            fprintf(report, "%-26s %12ld %14.1f %12.3f %12.3g %s/s\n", r.name, r.operations, r.ns_per_op, r.allocations_per_op, r.units_per_second, r.unit);
+        }
+    }
+    fflush(report);
+}
+
+int main(int argc, char *args[]) {
+    enum Output_Format format = FORMAT_TEXT;
+    int scaling_threads = 0;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(args[i], "--json")) {
+            format = FORMAT_JSON;
+        }
+        else if (!strcmp(args[i], "--csv")) {
+            format = FORMAT_CSV;
+        }
+        else if (!strcmp(args[i], "--scaling")) {
+            scaling_threads = sysconf(_SC_NPROCESSORS_ONLN);
+        }
+        else if (!strncmp(args[i], "--scaling=", 10) && atoi(args[i] + 10) > 0) {
+            scaling_threads = atoi(args[i] + 10);
+        }
+        else {
+            printf("usage: bench_dungeon [--json | --csv] [--scaling[=<max threads>]]\n");
+            exit(1);
+        }
+    }
+
+    // print_board draws frames on stdout, so results go to a copy of it and
+    // the engine's output is thrown away.
+    report = fdopen(dup(STDOUT_FILENO), "w");
+    fflush(stdout);
+    int null_fd = open("/dev/null", O_WRONLY);
+    dup2(null_fd, STDOUT_FILENO);
+    close(null_fd);
+
+    Dungeon * d = create_new_dungeon();
+    d->verbose = 0;
+    d->rooms = malloc(sizeof(struct Room) * d->number_of_rooms);
+    bench_generation(d, 200);
+    set_up_game(d);
+    bench_distance_map(d, "tunneling_buckets", set_tunneling_distance_with_buckets, 500);
+    bench_distance_map(d, "tunneling_heap", set_tunneling_distance_with_heap, 100);
+    bench_distance_map(d, "non_tunneling_bfs", set_non_tunneling_distance_with_bfs, 500);
+    bench_distance_map(d, "non_tunneling_heap", set_non_tunneling_distance_with_heap, 100);
+    bench_queue(d, 200);
+    bench_lowest_neighbors(d, 200);
+    for (int type = 0; type < 16; type++) {
+        bench_monster_moves(d, type, 200);
+    }
+    bench_print_board(d, "print_board", 0, 500);
+    bench_print_board(d, "print_board_incremental", 1, 500);
+    bench_load(d, 0, 500);
+    bench_load(d, 1, 500);
+    bench_restore_snapshot(d, 500);
+    if (scaling_threads) {
+        bench_path_scaling(scaling_threads, SCALING_ITERATIONS);
+    }
+
+    print_results(format);
+    free_dungeon(d);
+    return 0;
+}
@@ -0,0 +1,79 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "bucket_queue.h"
+
+static void link_key(Bucket_Queue *q, int key, int priority) {
+    int bucket = priority % q->num_buckets;
+    int head = q->heads[bucket];
+    q->priorities[key] = priority;
+    q->prev[key] = -1;
+    q->next[key] = head;
+    if (head != -1) {
+        q->prev[head] = key;
+    }
+    q->heads[bucket] = key;
+}
+
+static void unlink_key(Bucket_Queue *q, int key) {
+    int bucket = q->priorities[key] % q->num_buckets;
+    if (q->prev[key] != -1) {
+        q->next[q->prev[key]] = q->next[key];
+    }
+    else {
+        q->heads[bucket] = q->next[key];
+    }
+    if (q->next[key] != -1) {
+        q->prev[q->next[key]] = q->prev[key];
+    }
+    q->priorities[key] = -1;
+}
+
+Bucket_Queue *create_new_bucket_queue(int num_keys, int max_weight) {
+    Bucket_Queue *q = malloc(sizeof(Bucket_Queue));
+    q->length = 0;
+    q->current = 0;
+    q->num_buckets = max_weight + 1;
+    q->heads = malloc(sizeof(int) * q->num_buckets);
+    q->next = malloc(sizeof(int) * num_keys);
+    q->prev = malloc(sizeof(int) * num_keys);
+    q->priorities = malloc(sizeof(int) * num_keys);
+    memset(q->heads, -1, sizeof(int) * q->num_buckets);
+    memset(q->priorities, -1, sizeof(int) * num_keys);
+    return q;
+}
+
+void free_bucket_queue(Bucket_Queue *q) {
+    free(q->heads);
+    free(q->next);
+    free(q->prev);
+    free(q->priorities);
+    free(q);
+}
+
+void bucket_insert_with_priority(Bucket_Queue *q, int key, int priority) {
+    if (q->length == 0) {
+        q->current = priority;
+    }
+    link_key(q, key, priority);
+    q->length ++;
+}
+
+int bucket_extract_min(Bucket_Queue *q) {
+    while (q->heads[q->current % q->num_buckets] == -1) {
+        q->current ++;
+    }
+    int key = q->heads[q->current % q->num_buckets];
+    unlink_key(q, key);
+    q->length --;
+    return key;
+}
+
+void bucket_decrease_priority(Bucket_Queue *q, int key, int priority) {
+    if (q->priorities[key] == -1) {
+        bucket_insert_with_priority(q, key, priority);
+        return;
+    }
+    unlink_key(q, key);
+    link_key(q, key, priority);
+}
@@ -0,0 +1,20 @@
+/*
+ * Monotone bucket queue (Dial's algorithm) over integer keys. Every queued
+ * priority has to lie within max_weight of the last extracted one, which
+ * holds for Dijkstra when no edge weighs more than max_weight.
+ */
+typedef struct {
+    int length;
+    int current;
+    int num_buckets;
+    int * heads;
+    int * next;
+    int * prev;
+    int * priorities;
+} Bucket_Queue;
+
+Bucket_Queue * create_new_bucket_queue(int num_keys, int max_weight);
+void free_bucket_queue(Bucket_Queue * q);
+void bucket_insert_with_priority(Bucket_Queue *q, int key, int priority);
+int bucket_extract_min(Bucket_Queue *q);
+void bucket_decrease_priority(Bucket_Queue *q, int key, int priority);
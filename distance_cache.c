@@ -0,0 +1,145 @@
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <arpa/inet.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+#include "dungeon.h"
+
+#define DISTANCE_CACHE_BYTE_ORDER 0x01020304
+#define FNV_OFFSET_BASIS 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+
+// What the cached maps were computed for. The maps only depend on the
+// hardness plane and where the player stands, so a cache whose key does not
+// match the dungeon being played is stale.
+struct Distance_Cache_Key {
+    uint32_t byte_order;
+    uint32_t width;
+    uint32_t height;
+    uint32_t player_x;
+    uint32_t player_y;
+    uint32_t padding;
+    uint64_t hardness_hash;
+};
+
+// FNV-1a over the hardness plane.
+uint64_t hash_hardness(Dungeon * d) {
+    uint64_t hash = FNV_OFFSET_BASIS;
+    for (int i = 0; i < d->width * d->height; i++) {
+        hash = (hash ^ d->board.hardness[i]) * FNV_PRIME;
+    }
+    return hash;
+}
+
+void get_distance_cache_path(Dungeon * d, char * path, int size) {
+    if (snprintf(path, size, "%s%s", d->rlg_directory, DISTANCE_CACHE_FILE_NAME) >= size) {
+        printf("Distance cache path is too long: %s%s\n", d->rlg_directory, DISTANCE_CACHE_FILE_NAME);
+        exit(1);
+    }
+}
+
+long get_distance_cache_size(Dungeon * d) {
+    return DUNGEON_HEADER_SIZE + sizeof(struct Distance_Cache_Key) + ((long) d->width * d->height * sizeof(uint32_t) * 2);
+}
+
+void fill_distance_cache_header(Dungeon * d, uint8_t * header) {
+    uint32_t version = htonl(0);
+    uint32_t file_size = htonl(get_distance_cache_size(d));
+    memcpy(header, DISTANCE_CACHE_FILE_MARKER, DUNGEON_MARKER_SIZE);
+    memcpy(header + DUNGEON_MARKER_SIZE, &version, 4);
+    memcpy(header + DUNGEON_MARKER_SIZE + 4, &file_size, 4);
+}
+
+void fill_distance_cache_key(Dungeon * d, struct Distance_Cache_Key * key) {
+    memset(key, 0, sizeof(*key));
+    key->byte_order = DISTANCE_CACHE_BYTE_ORDER;
+    key->width = d->width;
+    key->height = d->height;
+    key->player_x = d->player.x;
+    key->player_y = d->player.y;
+    key->hardness_hash = hash_hardness(d);
+}
+
+// Reads both distance maps straight into the board with one readv when the
+// cache beside the saved dungeon was computed for this board and player.
+// Returns 0, leaving the maps to be computed, when there is no cache or it is
+// stale.
+int load_distance_cache(Dungeon * d) {
+    char filepath[PATH_MAX];
+    get_distance_cache_path(d, filepath, sizeof(filepath));
+    int fd = open(filepath, O_RDONLY);
+    if (fd == -1) {
+        return 0;
+    }
+    uint8_t header[DUNGEON_HEADER_SIZE];
+    uint8_t expected_header[DUNGEON_HEADER_SIZE];
+    struct Distance_Cache_Key key;
+    struct Distance_Cache_Key expected_key;
+    struct stat file_stat;
+    fill_distance_cache_header(d, expected_header);
+    fill_distance_cache_key(d, &expected_key);
+    if (fstat(fd, &file_stat) == -1 || file_stat.st_size != get_distance_cache_size(d) ||
+            read(fd, header, DUNGEON_HEADER_SIZE) != DUNGEON_HEADER_SIZE ||
+            memcmp(header, expected_header, DUNGEON_HEADER_SIZE) != 0 ||
+            read(fd, &key, sizeof(key)) != sizeof(key) ||
+            memcmp(&key, &expected_key, sizeof(key)) != 0) {
+        close(fd);
+        return 0;
+    }
+    struct iovec parts[2];
+    parts[0].iov_base = d->board.tunneling_distance;
+    parts[0].iov_len = sizeof(uint32_t) * d->width * d->height;
+    parts[1].iov_base = d->board.non_tunneling_distance;
+    parts[1].iov_len = sizeof(uint32_t) * d->width * d->height;
+    int loaded = readv(fd, parts, 2) == (long) (parts[0].iov_len + parts[1].iov_len);
+    close(fd);
+    return loaded;
+}
+
+// Writes the cache to a temporary file and renames it into place, so games
+// loading the same dungeon at the same time never read a partial cache.
+// mkstemp makes the file 0600, so it is given the saved dungeon's mode.
+void save_distance_cache(Dungeon * d) {
+    char filepath[PATH_MAX];
+    char temporary_path[PATH_MAX + 8];
+    get_distance_cache_path(d, filepath, sizeof(filepath));
+    snprintf(temporary_path, sizeof(temporary_path), "%s.XXXXXX", filepath);
+    int fd = mkstemp(temporary_path);
+    if (fd == -1) {
+        return;
+    }
+    char dungeon_path[PATH_MAX];
+    get_dungeon_path(d, dungeon_path, sizeof(dungeon_path));
+    struct stat dungeon_stat;
+    mode_t mode = stat(dungeon_path, &dungeon_stat) == -1 ? 0644 : dungeon_stat.st_mode & 0777;
+    if (fchmod(fd, mode) == -1) {
+        close(fd);
+        unlink(temporary_path);
+        return;
+    }
+    struct Distance_Cache_Key key;
+    fill_distance_cache_key(d, &key);
+    uint8_t header[DUNGEON_HEADER_SIZE];
+    fill_distance_cache_header(d, header);
+
+    struct iovec parts[4];
+    parts[0].iov_base = header;
+    parts[0].iov_len = DUNGEON_HEADER_SIZE;
+    parts[1].iov_base = &key;
+    parts[1].iov_len = sizeof(key);
+    parts[2].iov_base = d->board.tunneling_distance;
+    parts[2].iov_len = sizeof(uint32_t) * d->width * d->height;
+    parts[3].iov_base = d->board.non_tunneling_distance;
+    parts[3].iov_len = sizeof(uint32_t) * d->width * d->height;
+    int saved = writev(fd, parts, 4) == get_distance_cache_size(d);
+    close(fd);
+    if (!saved || rename(temporary_path, filepath) == -1) {
+        unlink(temporary_path);
+    }
+}
@@ -0,0 +1,1952 @@
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <math.h>
+#include <limits.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <sys/uio.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "dungeon.h"
+
+static const char CELL_GLYPHS[] = {' ', '.', '#'};
+static const char HEX_DIGITS[] = "0123456789abcdef";
+
+Dungeon * create_new_dungeon() {
+    Dungeon * d = malloc(sizeof(Dungeon));
+    memset(d, 0, sizeof(Dungeon));
+    d->player_is_alive = 1;
+    d->player_killed_by = -1;
+    d->verbose = 1;
+    d->number_of_rooms = MIN_NUMBER_OF_ROOMS;
+    d->max_room_width = DEFAULT_MAX_ROOM_WIDTH;
+    d->max_room_height = DEFAULT_MAX_ROOM_HEIGHT;
+    d->number_of_monsters = DEFAULT_NUMBER_OF_MONSTERS;
+    d->turn_threads = 1;
+    d->path_threads = 1;
+    set_dungeon_size(d, DEFAULT_WIDTH, DEFAULT_HEIGHT);
+    return d;
+}
+
+static void free_board(Dungeon * d) {
+    free(d->board.hardness);
+    free(d->board.type);
+    free(d->board.tunneling_distance);
+    free(d->board.non_tunneling_distance);
+    free(d->board.monster);
+    free(d->placeable_areas);
+    free(d->room_occupancy);
+    free(d->non_tunneling_frontier);
+    free(d->frame_buffer);
+    free(d->frame_glyphs);
+    if (d->distance_queue) {
+        free_queue(d->distance_queue);
+    }
+    if (d->tunneling_buckets) {
+        free_bucket_queue(d->tunneling_buckets);
+    }
+    // Its buckets are sized to the map.
+    if (d->path_pool) {
+        free_path_pool(d->path_pool);
+        d->path_pool = NULL;
+    }
+}
+
+// Sizes every plane and work area for a width by height map. The board is
+// left empty, so this is done before generating or loading one.
+void set_dungeon_size(Dungeon * d, int width, int height) {
+    if (d->board.hardness && d->width == width && d->height == height) {
+        return;
+    }
+    free_board(d);
+    int cells = width * height;
+    d->width = width;
+    d->height = height;
+    int offsets[8] = {width, width - 1, width + 1, -width, -width + 1, -width - 1, 1, -1};
+    memcpy(d->neighbor_offsets, offsets, sizeof(offsets));
+    d->board.hardness = calloc(cells, sizeof(uint8_t));
+    d->board.type = calloc(cells, sizeof(uint8_t));
+    d->board.tunneling_distance = calloc(cells, sizeof(uint32_t));
+    d->board.non_tunneling_distance = calloc(cells, sizeof(uint32_t));
+    d->board.monster = calloc(cells, sizeof(Monster_Handle));
+    d->placeable_areas = malloc(sizeof(struct Coordinate) * cells);
+    d->room_occupancy_words = (width + 63) / 64;
+    d->room_occupancy = malloc(sizeof(uint64_t) * d->room_occupancy_words * height);
+    d->non_tunneling_frontier = malloc(sizeof(int) * cells);
+    d->frame_buffer = NULL;
+    d->frame_glyphs = NULL;
+    d->frame_is_drawn = 0;
+    d->distance_queue = NULL;
+    d->tunneling_buckets = create_new_bucket_queue(cells, MAX_TUNNELING_WEIGHT);
+}
+
+// Sizes the board for a dungeon read from a file, holding it to the limits
+// --width and --height have.
+void set_dungeon_size_from_file(Dungeon * d, long width, long height, char * name) {
+    if (width < MIN_MAP_WIDTH || height < MIN_MAP_HEIGHT || width > MAX_MAP_SIZE || height > MAX_MAP_SIZE) {
+        printf("'%s' is %ldx%ld but dungeons have to be between %dx%d and %dx%d\n", name, width, height,
+                MIN_MAP_WIDTH, MIN_MAP_HEIGHT, MAX_MAP_SIZE, MAX_MAP_SIZE);
+        exit(1);
+    }
+    set_dungeon_size(d, width, height);
+}
+
+// MAX_NUMBER_OF_ROOMS on the default map, and proportionally more on larger
+// ones, up to what a version 1 file can hold.
+int get_max_number_of_rooms(Dungeon * d) {
+    long max_rooms = (long) MAX_NUMBER_OF_ROOMS * d->width * d->height / (DEFAULT_WIDTH * DEFAULT_HEIGHT);
+    if (max_rooms < MAX_NUMBER_OF_ROOMS) {
+        return MAX_NUMBER_OF_ROOMS;
+    }
+    if (max_rooms > UINT16_MAX) {
+        return UINT16_MAX;
+    }
+    return max_rooms;
+}
+
+void free_dungeon(Dungeon * d) {
+    free(d->rooms);
+    free(d->monsters);
+    free(d->monster_generations);
+    free(d->free_monster_slots);
+    free(d->rlg_directory);
+    if (d->turn_scheduler) {
+        free_scheduler(d->turn_scheduler);
+    }
+    free(d->decided_moves);
+    if (d->turn_pool) {
+        free_turn_pool(d->turn_pool);
+    }
+    free_board(d);
+    free(d);
+}
+
+void generate_dungeon(Dungeon * d) {
+    initialize_board(d);
+    free(d->rooms);
+    d->rooms = malloc(sizeof(struct Room) * d->number_of_rooms);
+    dig_rooms(d, d->number_of_rooms);
+    dig_cooridors(d);
+}
+
+// Places the player and the monsters on a generated or loaded dungeon and
+// queues everyone's first turn.
+void start_game(Dungeon * d) {
+    d->turn_scheduler = create_new_scheduler(d->number_of_monsters + 1);
+    place_player(d);
+    update_player_room(d);
+    set_placeable_areas(d);
+    if (d->cache_distances && load_distance_cache(d)) {
+        if (d->verbose) {
+            printf("Using cached distance maps\n");
+        }
+    }
+    else {
+        set_non_tunneling_distance_to_player(d);
+        set_tunneling_distance_to_player(d);
+        if (d->cache_distances) {
+            save_distance_cache(d);
+        }
+    }
+    if (d->check_pathing) {
+        check_distance_maps(d, "generation");
+    }
+    generate_monsters(d);
+}
+
+// Plays the next turn in the schedule and returns the entity that moved.
+// With turn threads, the first monster turn on a tick decides the moves of
+// every monster due on it ahead; each move is still made on its own turn.
+int play_turn(Dungeon * d) {
+    uint64_t tick;
+    int entity = next_turn(d->turn_scheduler, &tick);
+    int speed;
+    Rng rng;
+    seed_turn_rng(d, &rng, tick, entity);
+    if (entity == PLAYER_ENTITY) {
+        speed = 10;
+        move_player(d, &rng);
+        d->player_version ++;
+        // Monsters due after the player on this tick decide from the new
+        // maps.
+        d->decided_tick = UINT64_MAX;
+        set_non_tunneling_distance_to_player(d);
+        set_tunneling_distance_to_player(d);
+        if (d->check_pathing) {
+            check_distance_maps(d, "player move");
+        }
+    }
+    else {
+        int monster_index = entity - 1;
+        if (d->turn_threads > 1 && tick != d->decided_tick) {
+            decide_turns_ahead(d, entity, tick);
+        }
+        apply_monster_move(d, monster_index, get_move_for_turn(d, monster_index, tick, &rng));
+        speed = d->monsters[monster_index].speed;
+    }
+    d->turns ++;
+    schedule_turn(d->turn_scheduler, entity, tick + (1000/speed));
+    return entity;
+}
+
+int game_is_over(Dungeon * d) {
+    if (d->max_turns && d->turns >= d->max_turns) {
+        return 1;
+    }
+    return !d->number_of_monsters || !d->player_is_alive;
+}
+
+void update_number_of_rooms(Dungeon * d) {
+    if (d->number_of_rooms < MIN_NUMBER_OF_ROOMS) {
+        printf("Minimum number of rooms is %d\n", MIN_NUMBER_OF_ROOMS);
+        d->number_of_rooms = MIN_NUMBER_OF_ROOMS;
+    }
+    if (d->number_of_rooms > get_max_number_of_rooms(d)) {
+        printf("Maximum number of rooms is %d\n", get_max_number_of_rooms(d));
+        d->number_of_rooms = get_max_number_of_rooms(d);
+    }
+}
+
+void make_rlg_directory(Dungeon * d) {
+    char * home = getenv("HOME");
+    if (home == NULL) {
+        home = ".";
+    }
+    int length = snprintf(NULL, 0, "%s%s", home, RLG_DIRECTORY_NAME);
+    d->rlg_directory = malloc(length + 1);
+    snprintf(d->rlg_directory, length + 1, "%s%s", home, RLG_DIRECTORY_NAME);
+    mkdir(d->rlg_directory, 0777);
+}
+
+// Writes the path of the saved dungeon into path. Exits if it does not fit.
+void get_dungeon_path(Dungeon * d, char * path, int size) {
+    if (snprintf(path, size, "%s%s", d->rlg_directory, DUNGEON_FILE_NAME) >= size) {
+        printf("Dungeon path is too long: %s%s\n", d->rlg_directory, DUNGEON_FILE_NAME);
+        exit(1);
+    }
+}
+
+void fill_dungeon_header(uint8_t * header, uint32_t version, uint32_t file_size) {
+    version = htonl(version);
+    file_size = htonl(file_size);
+    memcpy(header, DUNGEON_FILE_MARKER, DUNGEON_MARKER_SIZE);
+    memcpy(header + DUNGEON_MARKER_SIZE, &version, 4);
+    memcpy(header + DUNGEON_MARKER_SIZE + 4, &file_size, 4);
+}
+
+void save_board(Dungeon * d, int version) {
+    char filepath[PATH_MAX];
+    get_dungeon_path(d, filepath, sizeof(filepath));
+    printf("Saving file to: %s\n", filepath);
+    int fd = open(filepath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1) {
+        printf("Cannot save file\n");
+        return;
+    }
+    int saved;
+    if (version == 1) {
+        saved = save_board_version_1(d, fd);
+    }
+    else {
+        saved = save_board_version_0(d, fd);
+    }
+    if (!saved) {
+        printf("Cannot save file\n");
+    }
+    close(fd);
+}
+
+// The header, hardness plane and rooms go out in one writev, with the
+// hardness written straight from the board. Returns 1 on success.
+int save_board_version_0(Dungeon * d, int fd) {
+    if (d->width != DEFAULT_WIDTH || d->height != DEFAULT_HEIGHT) {
+        printf("Version 0 only holds %dx%d dungeons; save this one as version 1\n", DEFAULT_WIDTH, DEFAULT_HEIGHT);
+        return 0;
+    }
+    uint8_t header[DUNGEON_HEADER_SIZE];
+    int file_size = DUNGEON_HEADER_SIZE + (d->height * d->width) + (d->number_of_rooms * 4);
+    fill_dungeon_header(header, 0, file_size);
+
+    uint8_t * room_bytes = malloc(d->number_of_rooms * 4);
+    for (int i = 0; i < d->number_of_rooms; i++) {
+        struct Room room = d->rooms[i];
+        room_bytes[(i * 4)] = room.start_x;
+        room_bytes[(i * 4) + 1] = room.start_y;
+        room_bytes[(i * 4) + 2] = room.end_x - room.start_x + 1;
+        room_bytes[(i * 4) + 3] = room.end_y - room.start_y + 1;
+    }
+
+    struct iovec parts[3];
+    parts[0].iov_base = header;
+    parts[0].iov_len = DUNGEON_HEADER_SIZE;
+    parts[1].iov_base = d->board.hardness;
+    parts[1].iov_len = d->height * d->width;
+    parts[2].iov_base = room_bytes;
+    parts[2].iov_len = d->number_of_rooms * 4;
+    int saved = writev(fd, parts, 3) == file_size;
+    free(room_bytes);
+    return saved;
+}
+
+// Writes value as a varint: 7 bits a byte, low bits first, the top bit set
+// on every byte but the last. Returns the bytes written.
+static int write_varint(uint8_t * out, uint32_t value) {
+    int written = 0;
+    while (value >= 0x80) {
+        out[written++] = (value & 0x7f) | 0x80;
+        value >>= 7;
+    }
+    out[written++] = value;
+    return written;
+}
+
+// Reads a varint at in[*read], advancing *read. Returns 0 if it runs off the
+// end or does not fit in 32 bits.
+static int read_varint(const uint8_t * in, int length, int * read, uint32_t * value) {
+    uint32_t result = 0;
+    for (int shift = 0; shift < 32; shift += 7) {
+        if (*read >= length) {
+            return 0;
+        }
+        uint8_t byte = in[(*read)++];
+        result |= (uint32_t) (byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Codes the hardness plane as pairs of runs: a varint count of open cells,
+// a varint count of rock cells, then the hardness of those rock cells. Open
+// cells cost nothing but their share of a count, and every run decodes with
+// one memset or memcpy. Returns the encoded size.
+int encode_hardness_runs(Dungeon * d, uint8_t * out) {
+    const uint8_t * hardness = d->board.hardness;
+    int cells = d->width * d->height;
+    int read = 0;
+    int written = 0;
+    while (read < cells) {
+        int open = 0;
+        while (read + open < cells && hardness[read + open] == 0) {
+            open ++;
+        }
+        read += open;
+        int rock = 0;
+        while (read + rock < cells && hardness[read + rock] != 0) {
+            rock ++;
+        }
+        written += write_varint(out + written, open);
+        written += write_varint(out + written, rock);
+        memcpy(out + written, hardness + read, rock);
+        written += rock;
+        read += rock;
+    }
+    return written;
+}
+
+// Decodes the runs straight into the hardness and type planes, so loading a
+// version 1 dungeon never looks at a cell on its own. Returns -1 when the
+// runs are malformed or do not cover the board exactly.
+int decode_hardness_runs(Dungeon * d, const uint8_t * in, int length) {
+    int cells = d->width * d->height;
+    int read = 0;
+    int written = 0;
+    while (written < cells) {
+        uint32_t open;
+        uint32_t rock;
+        if (!read_varint(in, length, &read, &open) || !read_varint(in, length, &read, &rock) ||
+                open > (uint32_t) (cells - written) || rock > (uint32_t) (cells - written - open) ||
+                rock > (uint32_t) (length - read)) {
+            return -1;
+        }
+        memset(d->board.hardness + written, 0, open);
+        memset(d->board.type + written, TYPE_CORRIDOR, open);
+        written += open;
+        // Rock of hardness 0 would be an open cell typed as rock.
+        if (memchr(in + read, 0, rock) != NULL) {
+            return -1;
+        }
+        memcpy(d->board.hardness + written, in + read, rock);
+        memset(d->board.type + written, TYPE_ROCK, rock);
+        written += rock;
+        read += rock;
+    }
+    return read == length ? 0 : -1;
+}
+
+// Version 1 describes its own dimensions and run-length codes the hardness
+// plane:
+//   u16 width, u16 height, u16 number of rooms, u32 encoded hardness size,
+//   hardness runs (see encode_hardness_runs), then u16 x, y, width, height
+//   for each room.
+// All values are big-endian. Returns 1 on success.
+int save_board_version_1(Dungeon * d, int fd) {
+    uint8_t * encoded = malloc(HARDNESS_RUNS_MAX_SIZE(d->height * d->width));
+    int encoded_size = encode_hardness_runs(d, encoded);
+    int rooms_size = d->number_of_rooms * 8;
+    int file_size = DUNGEON_HEADER_SIZE + DUNGEON_V1_META_SIZE + encoded_size + rooms_size;
+
+    uint8_t header[DUNGEON_HEADER_SIZE];
+    fill_dungeon_header(header, 1, file_size);
+    uint16_t meta_16[3];
+    meta_16[0] = htons(d->width);
+    meta_16[1] = htons(d->height);
+    meta_16[2] = htons(d->number_of_rooms);
+    uint32_t encoded_size_field = htonl(encoded_size);
+    uint8_t meta[DUNGEON_V1_META_SIZE];
+    memcpy(meta, meta_16, 6);
+    memcpy(meta + 6, &encoded_size_field, 4);
+
+    uint16_t * room_fields = malloc(rooms_size);
+    for (int i = 0; i < d->number_of_rooms; i++) {
+        struct Room room = d->rooms[i];
+        room_fields[(i * 4)] = htons(room.start_x);
+        room_fields[(i * 4) + 1] = htons(room.start_y);
+        room_fields[(i * 4) + 2] = htons(room.end_x - room.start_x + 1);
+        room_fields[(i * 4) + 3] = htons(room.end_y - room.start_y + 1);
+    }
+
+    struct iovec parts[4];
+    parts[0].iov_base = header;
+    parts[0].iov_len = DUNGEON_HEADER_SIZE;
+    parts[1].iov_base = meta;
+    parts[1].iov_len = DUNGEON_V1_META_SIZE;
+    parts[2].iov_base = encoded;
+    parts[2].iov_len = encoded_size;
+    parts[3].iov_base = room_fields;
+    parts[3].iov_len = rooms_size;
+    int saved = writev(fd, parts, 4) == file_size;
+    free(encoded);
+    free(room_fields);
+    return saved;
+}
+
+// Checks the file size with fstat and reads the common header, then hands
+// the rest of the file to the reader for its version.
+void load_board(Dungeon * d) {
+    char filepath[PATH_MAX];
+    get_dungeon_path(d, filepath, sizeof(filepath));
+    if (d->verbose) {
+        printf("Loading dungeon: %s\n", filepath);
+    }
+    int fd = open(filepath, O_RDONLY);
+    if (fd == -1) {
+        printf("Cannot load '%s'\n", filepath);
+        exit(1);
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) == -1) {
+        printf("Cannot load '%s'\n", filepath);
+        exit(1);
+    }
+    uint8_t header[DUNGEON_HEADER_SIZE];
+    if (file_stat.st_size < DUNGEON_HEADER_SIZE || read(fd, header, DUNGEON_HEADER_SIZE) != DUNGEON_HEADER_SIZE) {
+        printf("'%s' is too short to be a dungeon\n", filepath);
+        exit(1);
+    }
+    int version = check_dungeon_header(d, header, file_stat.st_size, filepath);
+
+    int body_size = file_stat.st_size - DUNGEON_HEADER_SIZE;
+    if (version == 0) {
+        load_board_version_0(d, fd, body_size, filepath);
+    }
+    else {
+        uint8_t * body = malloc(body_size);
+        if (read(fd, body, body_size) != body_size) {
+            printf("Cannot read '%s'\n", filepath);
+            exit(1);
+        }
+        decode_board_version_1(d, body, body_size, filepath);
+        free(body);
+    }
+    close(fd);
+    finish_loading_board(d);
+}
+
+// Loads a whole dungeon file that is already in memory, such as an entry
+// of a mapped pack.
+void load_board_from_memory(Dungeon * d, const uint8_t * bytes, long size, char * name) {
+    if (size < DUNGEON_HEADER_SIZE) {
+        printf("'%s' is too short to be a dungeon\n", name);
+        exit(1);
+    }
+    int version = check_dungeon_header(d, bytes, size, name);
+    const uint8_t * body = bytes + DUNGEON_HEADER_SIZE;
+    int body_size = size - DUNGEON_HEADER_SIZE;
+    if (version == 0) {
+        int rooms_size = check_version_0_size(body_size, name);
+        set_dungeon_size_from_file(d, DEFAULT_WIDTH, DEFAULT_HEIGHT, name);
+        memcpy(d->board.hardness, body, d->height * d->width);
+        read_rooms_version_0(d, body + (d->height * d->width), rooms_size, name);
+        set_cell_types_from_hardness(d);
+    }
+    else {
+        decode_board_version_1(d, body, body_size, name);
+    }
+    finish_loading_board(d);
+}
+
+// Validates the marker and size in a dungeon header and returns its version.
+int check_dungeon_header(Dungeon * d, const uint8_t * header, long size, char * name) {
+    uint32_t version;
+    uint32_t file_size;
+    memcpy(&version, header + DUNGEON_MARKER_SIZE, 4);
+    memcpy(&file_size, header + DUNGEON_MARKER_SIZE + 4, 4);
+    version = ntohl(version);
+    file_size = ntohl(file_size);
+    if (memcmp(header, DUNGEON_FILE_MARKER, DUNGEON_MARKER_SIZE) != 0) {
+        printf("'%s' is not an RLG327 dungeon\n", name);
+        exit(1);
+    }
+    if (file_size != size) {
+        printf("Dungeon header says %u bytes but '%s' is %ld bytes\n", file_size, name, size);
+        exit(1);
+    }
+    if (version != 0 && version != 1) {
+        printf("Unsupported dungeon version %u\n", version);
+        exit(1);
+    }
+    if (d->verbose) {
+        printf("File Marker: %.*s :: Version: %u :: File Size: %u bytes\n", DUNGEON_MARKER_SIZE, header, version, file_size);
+    }
+    return version;
+}
+
+// Version 0 only stores hardness, so open cells start as corridors until
+// the rooms are added.
+void set_cell_types_from_hardness(Dungeon * d) {
+    for (int i = 0; i < d->height * d->width; i++) {
+        if (d->board.hardness[i] == 0) {
+            d->board.type[i] = TYPE_CORRIDOR;
+        }
+        else {
+            d->board.type[i] = TYPE_ROCK;
+        }
+    }
+}
+
+void finish_loading_board(Dungeon * d) {
+    // NO_MONSTER is 0.
+    memset(d->board.monster, 0, sizeof(Monster_Handle) * d->height * d->width);
+
+    // The neighbor loops rely on the outer ring being immutable rock.
+    initialize_immutable_rock(d);
+    add_rooms_to_board(d);
+}
+
+// Returns the size of the room records in a version 0 body. Version 0
+// dungeons are always the default size.
+int check_version_0_size(int body_size, char * name) {
+    int rooms_size = body_size - (DEFAULT_HEIGHT * DEFAULT_WIDTH);
+    if (rooms_size < 0 || rooms_size % 4 != 0) {
+        printf("'%s' is %d bytes, which is not a valid dungeon size\n", name, body_size + DUNGEON_HEADER_SIZE);
+        exit(1);
+    }
+    return rooms_size;
+}
+
+// Reads the hardness plane straight into the board and the room records
+// after it with one readv.
+void load_board_version_0(Dungeon * d, int fd, int body_size, char * filepath) {
+    int rooms_size = check_version_0_size(body_size, filepath);
+    set_dungeon_size_from_file(d, DEFAULT_WIDTH, DEFAULT_HEIGHT, filepath);
+    uint8_t * room_bytes = malloc(rooms_size + 1);
+    struct iovec parts[2];
+    parts[0].iov_base = d->board.hardness;
+    parts[0].iov_len = d->height * d->width;
+    parts[1].iov_base = room_bytes;
+    parts[1].iov_len = rooms_size;
+    if (readv(fd, parts, 2) != body_size) {
+        printf("Cannot read '%s'\n", filepath);
+        exit(1);
+    }
+    read_rooms_version_0(d, room_bytes, rooms_size, filepath);
+    free(room_bytes);
+    set_cell_types_from_hardness(d);
+}
+
+void read_rooms_version_0(Dungeon * d, const uint8_t * room_bytes, int rooms_size, char * name) {
+    allocate_rooms_from_file(d, rooms_size / 4, name);
+    for (int i = 0; i < d->number_of_rooms; i++) {
+        const uint8_t * bytes = room_bytes + (i * 4);
+        set_room_from_file(d, i, bytes[0], bytes[1], bytes[2], bytes[3], name);
+    }
+}
+
+// Decodes the hardness plane of a version 1 body straight into the board.
+void decode_board_version_1(Dungeon * d, const uint8_t * body, int body_size, char * name) {
+    if (body_size < DUNGEON_V1_META_SIZE) {
+        printf("'%s' is too short to be a version 1 dungeon\n", name);
+        exit(1);
+    }
+    uint16_t meta_16[3];
+    uint32_t encoded_size;
+    memcpy(meta_16, body, 6);
+    memcpy(&encoded_size, body + 6, 4);
+    int width = ntohs(meta_16[0]);
+    int height = ntohs(meta_16[1]);
+    int number_of_rooms = ntohs(meta_16[2]);
+    encoded_size = ntohl(encoded_size);
+    if ((long) DUNGEON_V1_META_SIZE + encoded_size + (number_of_rooms * 8) != body_size) {
+        printf("'%s' has sections that do not add up to its size\n", name);
+        exit(1);
+    }
+    set_dungeon_size_from_file(d, width, height, name);
+    const uint8_t * encoded = body + DUNGEON_V1_META_SIZE;
+    if (decode_hardness_runs(d, encoded, encoded_size) == -1) {
+        printf("'%s' has a corrupt hardness plane\n", name);
+        exit(1);
+    }
+    allocate_rooms_from_file(d, number_of_rooms, name);
+    const uint8_t * room_fields = encoded + encoded_size;
+    for (int i = 0; i < d->number_of_rooms; i++) {
+        uint16_t fields[4];
+        memcpy(fields, room_fields + (i * 8), 8);
+        set_room_from_file(d, i, ntohs(fields[0]), ntohs(fields[1]), ntohs(fields[2]), ntohs(fields[3]), name);
+    }
+}
+
+// Replaces the rooms of the dungeon with room for those of a file. The player
+// starts in the first room, so a file has to hold at least one. Generation
+// stops short of MIN_NUMBER_OF_ROOMS once a small map is full, so files
+// holding fewer are still loaded.
+void allocate_rooms_from_file(Dungeon * d, int number_of_rooms, char * name) {
+    if (number_of_rooms < 1) {
+        printf("'%s' has no rooms\n", name);
+        exit(1);
+    }
+    free(d->rooms);
+    d->number_of_rooms = number_of_rooms;
+    d->rooms = malloc(sizeof(struct Room) * d->number_of_rooms);
+}
+
+void set_room_from_file(Dungeon * d, int index, int x, int y, int width, int height, char * name) {
+    if (!width || !height || x < 1 || y < 1 || x + width > d->width - 1 || y + height > d->height - 1) {
+        printf("Room %d of '%s' is not inside the dungeon\n", index, name);
+        exit(1);
+    }
+    struct Room room;
+    room.start_x = x;
+    room.start_y = y;
+    room.end_x = x + width - 1;
+    room.end_y = y + height - 1;
+    d->rooms[index] = room;
+}
+
+void seed_random_streams(Dungeon * d, uint64_t seed) {
+    for (int i = 0; i < NUMBER_OF_STREAMS; i++) {
+        seed_rng(&d->rng_streams[i], seed, i);
+    }
+}
+
+int random_int(Dungeon * d, int min_num, int max_num, enum Rng_Stream stream) {
+    return random_int_from(&d->rng_streams[stream], min_num, max_num);
+}
+
+int random_int_from(Rng * rng, int min_num, int max_num) {
+    uint32_t delta = (uint32_t) (max_num - min_num) + 1;
+    return min_num + random_below(rng, delta);
+}
+
+// Every turn rolls from its own generator, keyed by the movement stream, the
+// tick and the entity. Nothing else draws from the movement stream, so a
+// move decided ahead of its turn, on any thread, rolls exactly what it would
+// have rolled on its turn.
+void seed_turn_rng(Dungeon * d, Rng * rng, uint64_t tick, int entity) {
+    seed_rng(rng, d->rng_streams[STREAM_MOVEMENT].state ^ (tick * 0x9e3779b97f4a7c15ULL), entity);
+}
+
+void initialize_board(Dungeon * d) {
+    for (int y = 0; y < d->height; y++) {
+        for (int x = 0; x < d->width; x++) {
+            int index = cell_index(d, x, y);
+            d->board.hardness[index] = random_int(d, 1, 254, STREAM_TERRAIN);
+            d->board.type[index] = TYPE_ROCK;
+            d->board.monster[index] = NO_MONSTER;
+        }
+    }
+    initialize_immutable_rock(d);
+}
+
+void initialize_immutable_rock(Dungeon * d) {
+    int y;
+    int x;
+    int max_x = d->width - 1;
+    int max_y = d->height - 1;
+    for (y = 0; y < d->height; y++) {
+        d->board.hardness[cell_index(d, 0, y)] = IMMUTABLE_ROCK;
+        d->board.type[cell_index(d, 0, y)] = TYPE_ROCK;
+        d->board.hardness[cell_index(d, max_x, y)] = IMMUTABLE_ROCK;
+        d->board.type[cell_index(d, max_x, y)] = TYPE_ROCK;
+    }
+    for (x = 0; x < d->width; x++) {
+        d->board.hardness[cell_index(d, x, 0)] = IMMUTABLE_ROCK;
+        d->board.type[cell_index(d, x, 0)] = TYPE_ROCK;
+        d->board.hardness[cell_index(d, x, max_y)] = IMMUTABLE_ROCK;
+        d->board.type[cell_index(d, x, max_y)] = TYPE_ROCK;
+    }
+}
+
+void place_player(Dungeon * d) {
+    if (d->player.x >= d->width - 1 || d->player.y >= d->height - 1) {
+        printf("(%d, %d) is not inside the %dx%d dungeon\n", d->player.x, d->player.y, d->width, d->height);
+        exit(1);
+    }
+    if (!d->player.x && !d->player.y) {
+        struct Room room = d->rooms[0];
+        int x = random_int(d, room.start_x, room.end_x, STREAM_SPAWN);
+        int y = random_int(d, room.start_y, room.end_y, STREAM_SPAWN);
+        d->player.x = x;
+        d->player.y = y;
+    }
+    schedule_turn(d->turn_scheduler, PLAYER_ENTITY, 1000/10);
+}
+
+void set_placeable_areas(Dungeon * d) {
+    for (int y = 0; y < d->height; y++) {
+        for (int x = 0; x < d->width; x++) {
+            if (d->board.hardness[cell_index(d, x, y)] == 0 && (x != d->player.x || y != d->player.y)) {
+                struct Coordinate coord;
+                coord.x = x;
+                coord.y = y;
+                d->placeable_areas[d->number_of_placeable_areas] = coord;
+                d->number_of_placeable_areas++;
+            }
+        }
+    }
+}
+
+int get_cell_weight(int hardness) {
+    if (hardness == 0) {
+        return 1;
+    }
+    if (hardness <= 84) {
+        return 1;
+    }
+    if (hardness <= 170) {
+        return 2;
+    }
+    if (hardness <= 254) {
+        return 3;
+    }
+    return 1000;
+}
+
+int should_add_tunneling_neighbor(Dungeon * d, int index) {
+    return d->board.hardness[index] < IMMUTABLE_ROCK;
+}
+
+int should_add_non_tunneling_neighbor(Dungeon * d, int index) {
+    return d->board.hardness[index] < 1;
+}
+
+int should_use_path_threads(Dungeon * d) {
+    return d->path_threads > 1 && d->width * d->height >= MIN_CELLS_FOR_PATH_THREADS;
+}
+
+void set_tunneling_distance_to_player(Dungeon * d) {
+    if (d->use_heap_pathing) {
+        set_tunneling_distance_with_heap(d);
+    }
+    else if (should_use_path_threads(d)) {
+        set_tunneling_distance_in_parallel(d);
+    }
+    else {
+        set_tunneling_distance_with_buckets(d);
+    }
+}
+
+// The heap is only needed for --heap_pathing and --check_pathing, and on a
+// large map it is the biggest work area, so it is made on first use.
+void make_distance_queue(Dungeon * d) {
+    if (d->distance_queue == NULL) {
+        d->distance_queue = create_new_queue(d->width, d->height);
+    }
+    clear_queue(d->distance_queue);
+}
+
+void set_tunneling_distance_with_heap(Dungeon * d) {
+    make_distance_queue(d);
+    for (int y = 0; y < d->height; y++) {
+        for (int x = 0; x < d->width; x++) {
+            int index = cell_index(d, x, y);
+            int priority = INT_MAX;
+            struct Coordinate coord;
+            coord.x = x;
+            coord.y = y;
+            if (y == d->player.y && x == d->player.x) {
+                d->board.tunneling_distance[index] = 0;
+                priority = 0;
+            }
+            else {
+                d->board.tunneling_distance[index] = UNREACHABLE_TUNNELING;
+            }
+            if (should_add_tunneling_neighbor(d, index)) {
+                insert_with_priority(d->distance_queue, coord, priority);
+            }
+        }
+    }
+    while(d->distance_queue->length) {
+        Node min = extract_min(d->distance_queue);
+        int index = cell_index(d, min.coord.x, min.coord.y);
+        if (d->board.tunneling_distance[index] == UNREACHABLE_TUNNELING) {
+            break;
+        }
+        uint32_t min_dist = d->board.tunneling_distance[index] + get_cell_weight(d->board.hardness[index]);
+        for (int i = 0; i < 8; i++) {
+            int neighbor = index + d->neighbor_offsets[i];
+            if (should_add_tunneling_neighbor(d, neighbor) && min_dist < d->board.tunneling_distance[neighbor]) {
+                struct Coordinate coord;
+                coord.x = neighbor % d->width;
+                coord.y = neighbor / d->width;
+                d->board.tunneling_distance[neighbor] = min_dist;
+                decrease_priority(d->distance_queue, coord, min_dist);
+            }
+        }
+    }
+}
+
+// Cell weights are only 1, 2 or 3, so a bucket queue gives the same
+// distances as the heap in linear time.
+void set_tunneling_distance_with_buckets(Dungeon * d) {
+    for (int i = 0; i < d->height * d->width; i++) {
+        d->board.tunneling_distance[i] = UNREACHABLE_TUNNELING;
+    }
+    d->board.tunneling_distance[cell_index(d, d->player.x, d->player.y)] = 0;
+    bucket_insert_with_priority(d->tunneling_buckets, cell_index(d, d->player.x, d->player.y), 0);
+    relax_tunneling_distances(d);
+}
+
+// Runs Dijkstra from the cells already in tunneling_buckets, lowering
+// distances until none can be improved.
+void relax_tunneling_distances(Dungeon * d) {
+    while(d->tunneling_buckets->length) {
+        int index = bucket_extract_min(d->tunneling_buckets);
+        uint32_t min_dist = d->board.tunneling_distance[index] + get_cell_weight(d->board.hardness[index]);
+        for (int i = 0; i < 8; i++) {
+            int neighbor = index + d->neighbor_offsets[i];
+            if (should_add_tunneling_neighbor(d, neighbor) && min_dist < d->board.tunneling_distance[neighbor]) {
+                d->board.tunneling_distance[neighbor] = min_dist;
+                bucket_decrease_priority(d->tunneling_buckets, neighbor, min_dist);
+            }
+        }
+    }
+}
+
+void set_non_tunneling_distance_to_player(Dungeon * d) {
+    if (d->use_heap_pathing) {
+        set_non_tunneling_distance_with_heap(d);
+    }
+    else if (should_use_path_threads(d)) {
+        set_non_tunneling_distance_in_parallel(d);
+    }
+    else {
+        set_non_tunneling_distance_with_bfs(d);
+    }
+}
+
+void set_non_tunneling_distance_with_heap(Dungeon * d) {
+    make_distance_queue(d);
+    for (int y = 0; y < d->height; y++) {
+        for (int x = 0; x < d->width; x++) {
+            int index = cell_index(d, x, y);
+            int priority = INT_MAX;
+            struct Coordinate coord;
+            coord.x = x;
+            coord.y = y;
+            if (y == d->player.y && x == d->player.x) {
+                d->board.non_tunneling_distance[index] = 0;
+                priority = 0;
+            }
+            else {
+                d->board.non_tunneling_distance[index] = UNREACHABLE_NON_TUNNELING;
+            }
+            if (should_add_non_tunneling_neighbor(d, index)) {
+                insert_with_priority(d->distance_queue, coord, priority);
+            }
+        }
+    }
+    while(d->distance_queue->length) {
+        Node min = extract_min(d->distance_queue);
+        int index = cell_index(d, min.coord.x, min.coord.y);
+        if (d->board.non_tunneling_distance[index] == UNREACHABLE_NON_TUNNELING) {
+            break;
+        }
+        uint32_t min_dist = d->board.non_tunneling_distance[index] + 1;
+        for (int i = 0; i < 8; i++) {
+            int neighbor = index + d->neighbor_offsets[i];
+            if (should_add_non_tunneling_neighbor(d, neighbor) && min_dist < d->board.non_tunneling_distance[neighbor]) {
+                struct Coordinate coord;
+                coord.x = neighbor % d->width;
+                coord.y = neighbor / d->width;
+                d->board.non_tunneling_distance[neighbor] = min_dist;
+                decrease_priority(d->distance_queue, coord, min_dist);
+            }
+        }
+    }
+}
+
+// Every non-tunneling step costs 1, so a breadth first search visits cells
+// in the same order Dijkstra would.
+void set_non_tunneling_distance_with_bfs(Dungeon * d) {
+    int player_index = cell_index(d, d->player.x, d->player.y);
+    for (int i = 0; i < d->height * d->width; i++) {
+        d->board.non_tunneling_distance[i] = UNREACHABLE_NON_TUNNELING;
+    }
+    if (!should_add_non_tunneling_neighbor(d, player_index)) {
+        return;
+    }
+    d->board.non_tunneling_distance[player_index] = 0;
+    d->non_tunneling_frontier[0] = player_index;
+    relax_non_tunneling_distances(d, 1);
+}
+
+// Breadth first search from the first frontier_length cells of
+// non_tunneling_frontier, lowering distances until none can be improved.
+void relax_non_tunneling_distances(Dungeon * d, int frontier_length) {
+    int head = 0;
+    int tail = frontier_length;
+    while (head < tail) {
+        int index = d->non_tunneling_frontier[head++];
+        uint32_t min_dist = d->board.non_tunneling_distance[index] + 1;
+        for (int i = 0; i < 8; i++) {
+            int neighbor = index + d->neighbor_offsets[i];
+            if (should_add_non_tunneling_neighbor(d, neighbor) && min_dist < d->board.non_tunneling_distance[neighbor]) {
+                d->board.non_tunneling_distance[neighbor] = min_dist;
+                d->non_tunneling_frontier[tail++] = neighbor;
+            }
+        }
+    }
+}
+
+// Recomputes both maps with the heap-based Dijkstra and exits if the maps
+// on the board do not match it.
+void check_distance_maps(Dungeon * d, char * after) {
+    int cells = d->width * d->height;
+    uint32_t * tunneling = malloc(sizeof(uint32_t) * cells);
+    uint32_t * non_tunneling = malloc(sizeof(uint32_t) * cells);
+    memcpy(tunneling, d->board.tunneling_distance, sizeof(uint32_t) * cells);
+    memcpy(non_tunneling, d->board.non_tunneling_distance, sizeof(uint32_t) * cells);
+    set_tunneling_distance_with_heap(d);
+    set_non_tunneling_distance_with_heap(d);
+    int mismatches = 0;
+    for (int i = 0; i < d->height * d->width; i++) {
+        if (d->board.tunneling_distance[i] != tunneling[i] || d->board.non_tunneling_distance[i] != non_tunneling[i]) {
+            if (mismatches < 5) {
+                printf("Distance mismatch at (%d, %d): tunneling %u, expected %u; non-tunneling %u, expected %u\n",
+                        i % d->width, i / d->width, tunneling[i], d->board.tunneling_distance[i], non_tunneling[i], d->board.non_tunneling_distance[i]);
+            }
+            mismatches ++;
+        }
+    }
+    free(tunneling);
+    free(non_tunneling);
+    if (mismatches) {
+        printf("%d distance mismatches after %s\n", mismatches, after);
+        exit(1);
+    }
+}
+
+// Lowering the hardness of a single cell can only shorten paths that leave
+// through it, so only the cells reached from it need to be relaxed again.
+void repair_distances_after_tunneling(Dungeon * d, struct Coordinate coord, int old_weight, int opened) {
+    int index = cell_index(d, coord.x, coord.y);
+    if (opened) {
+        uint32_t nearest = UNREACHABLE_NON_TUNNELING;
+        for (int i = 0; i < 8; i++) {
+            int neighbor = index + d->neighbor_offsets[i];
+            if (should_add_non_tunneling_neighbor(d, neighbor) && d->board.non_tunneling_distance[neighbor] < nearest) {
+                nearest = d->board.non_tunneling_distance[neighbor];
+            }
+        }
+        if (nearest != UNREACHABLE_NON_TUNNELING) {
+            d->board.non_tunneling_distance[index] = nearest + 1;
+            d->non_tunneling_frontier[0] = index;
+            relax_non_tunneling_distances(d, 1);
+        }
+    }
+    int weight = get_cell_weight(d->board.hardness[index]);
+    if (weight < old_weight && d->board.tunneling_distance[index] != UNREACHABLE_TUNNELING) {
+        uint32_t min_dist = d->board.tunneling_distance[index] + weight;
+        for (int i = 0; i < 8; i++) {
+            int neighbor = index + d->neighbor_offsets[i];
+            if (should_add_tunneling_neighbor(d, neighbor) && min_dist < d->board.tunneling_distance[neighbor]) {
+                d->board.tunneling_distance[neighbor] = min_dist;
+                bucket_decrease_priority(d->tunneling_buckets, neighbor, min_dist);
+            }
+        }
+        relax_tunneling_distances(d);
+    }
+}
+
+// Wears down the rock at coord and brings the distance maps up to date.
+// Returns 1 when the cell is open and can be moved into.
+int tunnel_into_cell_at(Dungeon * d, struct Coordinate coord) {
+    int index = cell_index(d, coord.x, coord.y);
+    if (d->board.hardness[index] == 0) {
+        return 1;
+    }
+    if (d->board.hardness[index] == IMMUTABLE_ROCK) {
+        return 0;
+    }
+    int old_weight = get_cell_weight(d->board.hardness[index]);
+    int hardness = d->board.hardness[index] - 85;
+    int opened = 0;
+    if (hardness <= 0) {
+        hardness = 0;
+        d->board.type[index] = TYPE_CORRIDOR;
+        opened = 1;
+    }
+    d->board.hardness[index] = hardness;
+    d->hardness_version ++;
+    if (opened) {
+        d->open_cells_version ++;
+    }
+    if (d->use_heap_pathing) {
+        if (opened) {
+            set_non_tunneling_distance_to_player(d);
+        }
+        set_tunneling_distance_to_player(d);
+    }
+    else {
+        repair_distances_after_tunneling(d, coord, old_weight, opened);
+    }
+    if (d->check_pathing) {
+        check_distance_maps(d, "tunneling");
+    }
+    return opened;
+}
+
+struct Coordinate get_random_board_location(Dungeon * d) {
+    int index = random_int(d, 0, d->number_of_placeable_areas - 1, STREAM_SPAWN);
+    return d->placeable_areas[index];
+}
+
+void generate_monsters(Dungeon * d) {
+    if (d->number_of_monsters > d->number_of_placeable_areas) {
+        if (d->verbose) {
+            printf("Only room for %d monsters\n", d->number_of_placeable_areas);
+        }
+        d->number_of_monsters = d->number_of_placeable_areas;
+    }
+    d->monster_pool_size = d->number_of_monsters;
+    d->monsters = malloc(sizeof(struct Monster) * d->monster_pool_size);
+    d->monster_generations = malloc(sizeof(uint8_t) * d->monster_pool_size);
+    d->free_monster_slots = malloc(sizeof(int) * d->monster_pool_size);
+    for (int i = 0; i < d->monster_pool_size; i++) {
+        d->monster_generations[i] = 1;
+        d->free_monster_slots[i] = d->monster_pool_size - 1 - i;
+    }
+    d->number_of_free_monster_slots = d->monster_pool_size;
+    struct Coordinate last_known_player_location;
+    last_known_player_location.x = 0;
+    last_known_player_location.y = 0;
+    for (int i = 0; i < d->number_of_monsters; i++) {
+        struct Monster m;
+        // Zeroed so the padding written to snapshots is always the same.
+        memset(&m, 0, sizeof(m));
+        struct Coordinate coordinate;
+        while (1) {
+            coordinate = get_random_board_location(d);
+            if (d->board.monster[cell_index(d, coordinate.x, coordinate.y)] == NO_MONSTER) {
+                break;
+            }
+        }
+        m.speed = random_int(d, 5, 20, STREAM_SPAWN);
+        m.x = coordinate.x;
+        m.y = coordinate.y;
+        m.last_known_player_location = last_known_player_location;
+        m.decimal_type = random_int(d, 0, 15, STREAM_SPAWN);
+        if (d->verbose) {
+            printf("Made %dth monster;x: %d, y: %d, ability: %d, speed: %d\n", i, m.x, m.y, m.decimal_type, m.speed);
+        }
+        int index = allocate_monster_slot(d);
+        d->monsters[index] = m;
+        d->monsters_spawned_by_type[m.decimal_type] ++;
+        d->board.monster[cell_index(d, m.x, m.y)] = get_monster_handle(d, index);
+        schedule_turn(d->turn_scheduler, index + 1, 1000/m.speed);
+    }
+    reset_decided_moves(d);
+}
+
+void print_non_tunneling_board(Dungeon * d) {
+    printf("Printing non-tunneling board\n");
+    for (int y = 0; y < d->height; y++) {
+        for (int x = 0; x < d->width; x++) {
+           int index = cell_index(d, x, y);
+           if(x == d->player.x && y == d->player.y) {
+               printf("@");
+           }
+           else {
+               if (d->board.type[index] != TYPE_ROCK) {
+                   printf("%d", d->board.non_tunneling_distance[index] % 10);
+               }
+               else {
+                    printf(" ");
+               }
+           }
+        }
+        printf("\n");
+    }
+}
+void print_tunneling_board(Dungeon * d) {
+    printf("Printing tunneling board\n");
+    for (int y = 0; y < d->height; y++) {
+        for (int x = 0; x < d->width; x++) {
+           int index = cell_index(d, x, y);
+           if(x == d->player.x && y == d->player.y) {
+               printf("@");
+           }
+           else {
+               if (d->board.hardness[index] == IMMUTABLE_ROCK) {
+                   printf(" ");
+               }
+               else {
+                   printf("%d", d->board.tunneling_distance[index] % 10);
+               }
+           }
+        }
+        printf("\n");
+    }
+
+}
+
+
+void print_board(Dungeon * d) {
+    if (d->frame_buffer == NULL) {
+        // The cursor moves are at most 16 bytes while the map is at most
+        // 4096 cells across.
+        d->frame_buffer = malloc(((long) d->width * d->height * 16) + 64);
+        d->frame_glyphs = malloc(d->width * d->height);
+    }
+    char * out = d->frame_buffer;
+    int full_frame = !d->incremental_rendering || !d->frame_is_drawn;
+    if (full_frame && d->incremental_rendering) {
+        out += sprintf(out, "\x1b[2J\x1b[H");
+    }
+    for (int y = 0; y < d->height; y++) {
+        for (int x = 0; x < d->width; x++) {
+            int index = cell_index(d, x, y);
+            char glyph = get_cell_glyph(d, index);
+            if (full_frame) {
+                *out++ = glyph;
+            }
+            else if (glyph != d->frame_glyphs[index]) {
+                out += sprintf(out, "\x1b[%d;%dH%c", y + 1, x + 1, glyph);
+            }
+            d->frame_glyphs[index] = glyph;
+        }
+        if (full_frame) {
+            *out++ = '\n';
+        }
+    }
+    if (d->incremental_rendering) {
+        // Park the cursor under the board so messages do not land on it.
+        out += sprintf(out, "\x1b[%d;1H\x1b[J", d->height + 1);
+    }
+    d->frame_is_drawn = 1;
+    fflush(stdout);
+    if (write(STDOUT_FILENO, d->frame_buffer, out - d->frame_buffer) == -1) {
+        printf("Could not draw the board\n");
+    }
+}
+
+// Prints a message under the board. A message can scroll the terminal out
+// from under the cursor moves of an incremental frame, so the next frame is
+// drawn in full.
+void print_message(Dungeon * d, const char * format, ...) {
+    va_list args;
+    va_start(args, format);
+    vprintf(format, args);
+    va_end(args);
+    d->frame_is_drawn = 0;
+}
+
+char get_cell_glyph(Dungeon * d, int index) {
+    if (d->player_is_alive && index == cell_index(d, d->player.x, d->player.y)) {
+        return '@';
+    }
+    if (d->board.monster[index] != NO_MONSTER) {
+        // The grid only ever holds live handles, so the slot can be read
+        // straight off the handle.
+        return HEX_DIGITS[d->monsters[d->board.monster[index] & MONSTER_SLOT_MASK].decimal_type];
+    }
+    return CELL_GLYPHS[d->board.type[index]];
+}
+
+// Places up to number_of_rooms_to_dig rooms and lowers number_of_rooms to
+// however many fit.
+void dig_rooms(Dungeon * d, int number_of_rooms_to_dig) {
+    memset(d->room_occupancy, 0, sizeof(uint64_t) * d->room_occupancy_words * d->height);
+    for (int i = 0; i < number_of_rooms_to_dig; i++) {
+        if (!dig_room(d, i)) {
+            if (d->verbose) {
+                printf("Only room for %d rooms\n", i);
+            }
+            d->number_of_rooms = i;
+            break;
+        }
+    }
+    add_rooms_to_board(d);
+}
+
+// Tries a bounded number of random rooms, then falls back to the smallest
+// room at a random free spot. Returns 0 when not even that fits, so a full
+// map fails the same way every time instead of retrying forever.
+int dig_room(Dungeon * d, int index) {
+    for (int attempt = 0; attempt < ROOM_PLACEMENT_ATTEMPTS; attempt++) {
+        int room_height = random_int(d, MIN_ROOM_HEIGHT, d->max_room_height, STREAM_ROOMS);
+        int room_width = random_int(d, MIN_ROOM_WIDTH, d->max_room_width, STREAM_ROOMS);
+        struct Room room;
+        room.start_x = random_int(d, 1, d->width - 2 - room_width, STREAM_ROOMS);
+        room.start_y = random_int(d, 1, d->height - 2 - room_height, STREAM_ROOMS);
+        room.end_x = room.start_x + room_width;
+        room.end_y = room.start_y + room_height;
+        if (room_is_free(d, room)) {
+            place_room(d, index, room);
+            return 1;
+        }
+    }
+    return dig_smallest_room(d, index);
+}
+
+// Counts every spot where a minimum size room fits and takes a random one.
+int dig_smallest_room(Dungeon * d, int index) {
+    struct Room room;
+    int free_spots = 0;
+    for (int y = 1; y < d->height - 1 - MIN_ROOM_HEIGHT; y++) {
+        for (int x = 1; x < d->width - 1 - MIN_ROOM_WIDTH; x++) {
+            room.start_x = x;
+            room.start_y = y;
+            room.end_x = x + MIN_ROOM_WIDTH;
+            room.end_y = y + MIN_ROOM_HEIGHT;
+            free_spots += room_is_free(d, room);
+        }
+    }
+    if (!free_spots) {
+        return 0;
+    }
+    int chosen = random_int(d, 0, free_spots - 1, STREAM_ROOMS);
+    for (int y = 1; y < d->height - 1 - MIN_ROOM_HEIGHT; y++) {
+        for (int x = 1; x < d->width - 1 - MIN_ROOM_WIDTH; x++) {
+            room.start_x = x;
+            room.start_y = y;
+            room.end_x = x + MIN_ROOM_WIDTH;
+            room.end_y = y + MIN_ROOM_HEIGHT;
+            if (room_is_free(d, room) && chosen-- == 0) {
+                place_room(d, index, room);
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+// Mask of bits first_bit through last_bit of one occupancy word.
+static uint64_t get_span_mask(int first_bit, int last_bit) {
+    uint64_t mask = ~0ULL << first_bit;
+    if (last_bit < 63) {
+        mask &= (1ULL << (last_bit + 1)) - 1;
+    }
+    return mask;
+}
+
+// A room fits when none of its cells are in another room or the ring of
+// cells around one. Each row is checked a word of the occupancy bitmap at a
+// time.
+int room_is_free(Dungeon * d, struct Room room) {
+    for (int y = room.start_y; y <= room.end_y; y++) {
+        uint64_t * row = d->room_occupancy + (y * d->room_occupancy_words);
+        for (int word = room.start_x / 64; word <= room.end_x / 64; word++) {
+            int first_bit = word == room.start_x / 64 ? room.start_x % 64 : 0;
+            int last_bit = word == room.end_x / 64 ? room.end_x % 64 : 63;
+            if (row[word] & get_span_mask(first_bit, last_bit)) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+// Stores the room and marks it and the ring around it as occupied.
+void place_room(Dungeon * d, int index, struct Room room) {
+    d->rooms[index] = room;
+    int start_x = room.start_x - 1;
+    int end_x = room.end_x + 1;
+    for (int y = room.start_y - 1; y <= room.end_y + 1; y++) {
+        uint64_t * row = d->room_occupancy + (y * d->room_occupancy_words);
+        for (int word = start_x / 64; word <= end_x / 64; word++) {
+            int first_bit = word == start_x / 64 ? start_x % 64 : 0;
+            int last_bit = word == end_x / 64 ? end_x % 64 : 63;
+            row[word] |= get_span_mask(first_bit, last_bit);
+        }
+    }
+}
+
+void add_rooms_to_board(Dungeon * d) {
+    for(int i = 0; i < d->number_of_rooms; i++) {
+        struct Room room = d->rooms[i];
+        for (int y = room.start_y; y <= room.end_y; y++) {
+            for(int x = room.start_x; x <= room.end_x; x++) {
+                d->board.hardness[cell_index(d, x, y)] = ROOM;
+                d->board.type[cell_index(d, x, y)] = TYPE_ROOM;
+            }
+        }
+    }
+}
+
+void dig_cooridors(Dungeon * d) {
+    for (int i = 0; i < d->number_of_rooms; i++) {
+        int next_index = i + 1;
+        if (next_index == d->number_of_rooms) {
+            next_index = 0;
+        }
+        connect_rooms_at_indexes(d, i, next_index);
+    }
+}
+
+void connect_rooms_at_indexes(Dungeon * d, int index1, int index2) {
+    struct Room room1 = d->rooms[index1];
+    struct Room room2 = d->rooms[index2];
+    int start_x = ((room1.end_x - room1.start_x) / 2) + room1.start_x;
+    int end_x = ((room2.end_x - room2.start_x) / 2) + room2.start_x;
+    int start_y = ((room1.end_y - room1.start_y) / 2) + room1.start_y;
+    int end_y = ((room2.end_y - room2.start_y) / 2) + room2.start_y;
+    int x_incrementer = 1;
+    int y_incrementer = 1;
+    if (start_x > end_x) {
+        x_incrementer = -1;
+    }
+    if (start_y > end_y) {
+        y_incrementer = -1;
+    }
+    int cur_x = start_x;
+    int cur_y = start_y;
+    while(1) {
+        int move_y = random_int(d, 0, 1, STREAM_CORRIDORS);
+        int index = cell_index(d, cur_x, cur_y);
+        if (d->board.type[index] != TYPE_ROCK) {
+            if (cur_y != end_y) {
+                cur_y += y_incrementer;
+            }
+            else if(cur_x != end_x) {
+                cur_x += x_incrementer;
+            }
+            else if(cur_y == end_y && cur_x == end_x) {
+                break;
+            }
+            continue;
+        }
+        d->board.type[index] = TYPE_CORRIDOR;
+        d->board.hardness[index] = CORRIDOR;
+        if ((cur_y != end_y && move_y) || (cur_x == end_x)) {
+            cur_y += y_incrementer;
+        }
+        else if ((cur_x != end_x && !move_y) || (cur_y == end_y)) {
+            cur_x += x_incrementer;
+        }
+        else {
+            break;
+        }
+    }
+}
+
+int get_monster_index(Dungeon * d, struct Coordinate coord) {
+    return get_monster_index_for_handle(d, d->board.monster[cell_index(d, coord.x, coord.y)]);
+}
+
+Monster_Handle get_monster_handle(Dungeon * d, int index) {
+    return ((Monster_Handle) d->monster_generations[index] << MONSTER_SLOT_BITS) | index;
+}
+
+int get_monster_index_for_handle(Dungeon * d, Monster_Handle handle) {
+    if (handle == NO_MONSTER) {
+        return -1;
+    }
+    int index = handle & MONSTER_SLOT_MASK;
+    if (index >= d->monster_pool_size || get_monster_handle(d, index) != handle) {
+        return -1;
+    }
+    return index;
+}
+
+struct Available_Coords get_non_tunneling_available_coords_for(Dungeon * d, struct Coordinate coord) {
+    struct Available_Coords available_coords;
+    int index = cell_index(d, coord.x, coord.y);
+    available_coords.length = 0;
+    for (int i = 0; i < 8; i++) {
+        int neighbor = index + d->neighbor_offsets[i];
+        if (d->board.hardness[neighbor] == 0) {
+            struct Coordinate new_coord;
+            new_coord.x = neighbor % d->width;
+            new_coord.y = neighbor / d->width;
+            available_coords.coords[available_coords.length] = new_coord;
+            available_coords.length ++;
+        }
+    }
+    return available_coords;
+}
+
+struct Coordinate get_random_new_non_tunneling_location(Dungeon * d, struct Coordinate coord, Rng * rng) {
+    struct Available_Coords coords = get_non_tunneling_available_coords_for(d, coord);
+    if (!coords.length) {
+        return coord;
+    }
+    int new_coord_index = random_int_from(rng, 0, coords.length - 1);
+    return coords.coords[new_coord_index];
+}
+
+struct Coordinate get_random_new_tunneling_location(Dungeon * d, struct Coordinate coord, Rng * rng) {
+    // Pick uniformly among the neighbors that are not immutable rock, rather
+    // than rolling coordinates until one lands on a usable cell.
+    int candidates[8];
+    int length = 0;
+    int index = cell_index(d, coord.x, coord.y);
+    for (int i = 0; i < 8; i++) {
+        int neighbor = index + d->neighbor_offsets[i];
+        if (d->board.hardness[neighbor] != IMMUTABLE_ROCK) {
+            candidates[length] = neighbor;
+            length ++;
+        }
+    }
+    if (!length) {
+        return coord;
+    }
+    int chosen = candidates[random_int_from(rng, 0, length - 1)];
+    struct Coordinate new_coord;
+    new_coord.x = chosen % d->width;
+    new_coord.y = chosen / d->width;
+    return new_coord;
+}
+
+
+void move_player(Dungeon * d, Rng * rng) {
+    int found_monster = 0;
+    struct Coordinate new_coord;
+    struct Available_Coords coords = get_non_tunneling_available_coords_for(d, d->player);
+    for (int i = 0; i < coords.length; i++) {
+        struct Coordinate current_coord = coords.coords[i];
+        if (d->board.monster[cell_index(d, current_coord.x, current_coord.y)] != NO_MONSTER) {
+            found_monster = 1;
+            new_coord = current_coord;
+            break;
+        }
+    }
+    if (!found_monster) {
+        new_coord = get_random_new_non_tunneling_location(d, d->player, rng);
+    }
+    if (new_coord.x != d->player.x || new_coord.y != d->player.y) {
+        kill_player_or_monster_at(d, new_coord);
+    }
+    d->player.x = new_coord.x;
+    d->player.y = new_coord.y;
+    update_player_room(d);
+}
+
+struct Coordinate get_cell_for_index(Dungeon * d, int index) {
+    struct Coordinate coord;
+    coord.x = index % d->width;
+    coord.y = index / d->width;
+    return coord;
+}
+
+// The first neighbor, in neighbor_offsets order, closer to the player on
+// the distance plane than index, or index itself when none is. Kept as the
+// plain loop the faster versions below have to agree with.
+int get_lowest_neighbor_in_order(Dungeon * d, const uint32_t * distances, int index) {
+    int best = index;
+    for (int i = 0; i < 8; i++) {
+        int neighbor = index + d->neighbor_offsets[i];
+        if (distances[neighbor] < distances[best]) {
+            best = neighbor;
+        }
+    }
+    return best;
+}
+
+#ifdef __SSE2__
+// SSE2 only compares signed lanes, so distances are biased by 2^31 first to
+// keep their unsigned order.
+#define DISTANCE_BIAS INT32_MIN
+
+static inline __m128i select_lanes(__m128i mask, __m128i if_set, __m128i if_clear) {
+    return _mm_or_si128(_mm_and_si128(mask, if_set), _mm_andnot_si128(mask, if_clear));
+}
+
+static inline __m128i min_lanes(__m128i a, __m128i b) {
+    return select_lanes(_mm_cmplt_epi32(a, b), a, b);
+}
+#endif
+
+// Same answer as get_lowest_neighbor_in_order. The rows above and below are
+// each one unaligned load, with the cell east or west of index swapped in
+// for the spare lane, and the eight distances are reduced to their minimum.
+// The lowest lane in neighbor_offsets order gives the direction.
+int get_lowest_neighbor(Dungeon * d, const uint32_t * distances, int index) {
+#ifdef __SSE2__
+    int width = d->width;
+    __m128i bias = _mm_set1_epi32(DISTANCE_BIAS);
+    // Lanes E, SW, S, SE.
+    __m128i below = _mm_loadu_si128((const __m128i *) (distances + index + width - 2));
+    below = _mm_castps_si128(_mm_move_ss(_mm_castsi128_ps(below),
+            _mm_castsi128_ps(_mm_cvtsi32_si128(distances[index + 1]))));
+    // Lanes W, NW, N, NE. Loading from two cells back could start before
+    // the board, so the row is loaded from one back and rotated instead.
+    __m128i above = _mm_loadu_si128((const __m128i *) (distances + index - width - 1));
+    above = _mm_shuffle_epi32(above, _MM_SHUFFLE(2, 1, 0, 3));
+    above = _mm_castps_si128(_mm_move_ss(_mm_castsi128_ps(above),
+            _mm_castsi128_ps(_mm_cvtsi32_si128(distances[index - 1]))));
+    below = _mm_xor_si128(below, bias);
+    above = _mm_xor_si128(above, bias);
+    __m128i lowest = min_lanes(below, above);
+    lowest = min_lanes(lowest, _mm_shuffle_epi32(lowest, _MM_SHUFFLE(1, 0, 3, 2)));
+    lowest = min_lanes(lowest, _mm_shuffle_epi32(lowest, _MM_SHUFFLE(2, 3, 0, 1)));
+    uint32_t lowest_distance = (uint32_t) _mm_cvtsi128_si32(lowest) ^ (uint32_t) DISTANCE_BIAS;
+    if (lowest_distance >= distances[index]) {
+        return index;
+    }
+    int lanes = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(below, lowest))) |
+            (_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(above, lowest))) << 4);
+    // Lane bits E, SW, S, SE, W, NW, N, NE into the order of
+    // neighbor_offsets: S, SW, SE, N, NE, NW, E, W.
+    int in_order = ((lanes >> 2) & 1) | (lanes & 2) | ((lanes >> 1) & 4) | ((lanes >> 3) & 8) |
+            ((lanes >> 3) & 16) | (lanes & 32) | ((lanes << 6) & 64) | ((lanes << 3) & 128);
+    return index + d->neighbor_offsets[__builtin_ctz(in_order)];
+#else
+    return get_lowest_neighbor_in_order(d, distances, index);
+#endif
+}
+
+// get_lowest_neighbor for count cells at once. Each lane follows one cell
+// through the eight directions, keeping the closest neighbor seen so far,
+// so ties go to the same neighbor as the loop.
+void get_lowest_neighbors(Dungeon * d, const uint32_t * distances, const int * indexes, int * lowest, int count) {
+    int i = 0;
+#ifdef __SSE2__
+    __m128i bias = _mm_set1_epi32(DISTANCE_BIAS);
+    for (; i + 4 <= count; i += 4) {
+        __m128i cells = _mm_loadu_si128((const __m128i *) (indexes + i));
+        __m128i best_cells = cells;
+        __m128i best = _mm_xor_si128(_mm_set_epi32(distances[indexes[i + 3]], distances[indexes[i + 2]],
+                distances[indexes[i + 1]], distances[indexes[i]]), bias);
+        for (int direction = 0; direction < 8; direction++) {
+            int offset = d->neighbor_offsets[direction];
+            __m128i neighbors = _mm_add_epi32(cells, _mm_set1_epi32(offset));
+            __m128i neighbor_distances = _mm_xor_si128(_mm_set_epi32(distances[indexes[i + 3] + offset],
+                    distances[indexes[i + 2] + offset], distances[indexes[i + 1] + offset],
+                    distances[indexes[i] + offset]), bias);
+            __m128i closer = _mm_cmplt_epi32(neighbor_distances, best);
+            best = select_lanes(closer, neighbor_distances, best);
+            best_cells = select_lanes(closer, neighbors, best_cells);
+        }
+        _mm_storeu_si128((__m128i *) (lowest + i), best_cells);
+    }
+#endif
+    for (; i < count; i++) {
+        lowest[i] = get_lowest_neighbor(d, distances, indexes[i]);
+    }
+}
+
+struct Coordinate get_cell_on_tunneling_path(Dungeon * d, struct Coordinate c) {
+    int index = cell_index(d, c.x, c.y);
+    return get_cell_for_index(d, get_lowest_neighbor(d, d->board.tunneling_distance, index));
+}
+
+struct Coordinate get_cell_on_non_tunneling_path(Dungeon * d, struct Coordinate c) {
+    int index = cell_index(d, c.x, c.y);
+    return get_cell_for_index(d, get_lowest_neighbor(d, d->board.non_tunneling_distance, index));
+}
+
+// Finds the room the player stands in, or an empty room at (0, 0). Done once
+// per player move so monsters do not each search every room.
+void update_player_room(Dungeon * d) {
+    struct Room room;
+    room.start_x = 0;
+    room.end_x = 0;
+    room.start_y = 0;
+    room.end_y = 0;
+    for (int i = 0; i < d->number_of_rooms; i++) {
+        struct Room current_room = d->rooms[i];
+        if (current_room.start_x <= d->player.x && d->player.x <= current_room.end_x) {
+            if (current_room.start_y <= d->player.y && d->player.y <= current_room.end_y) {
+                room = current_room;
+                break;
+            }
+        }
+    }
+    d->player_room = room;
+}
+
+int monster_is_in_same_room_as_player(Dungeon * d, int index) {
+    struct Monster m = d->monsters[index];
+    struct Room room = d->player_room;
+    if (room.start_x <= m.x && m.x <= room.end_x) {
+        if (room.start_y <= m.y && m.y <= room.end_y) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int should_do_erratic_behavior(Rng * rng) {
+    return random_int_from(rng, 0, 1);
+}
+
+int monster_knows_last_player_location(Dungeon * d, int index) {
+    struct Monster m = d->monsters[index];
+    struct Coordinate last_known_player_location = m.last_known_player_location;
+    return last_known_player_location.x != 0 && last_known_player_location.y != 0;
+}
+
+struct Coordinate get_straight_path_to(Dungeon * d, int index, struct Coordinate coord) {
+    struct Monster m = d->monsters[index];
+    struct Coordinate new_coord;
+    if (m.x == coord.x) {
+        new_coord.x = m.x;
+    }
+    else if (m.x < coord.x) {
+        new_coord.x = m.x + 1;
+    }
+    else {
+        new_coord.x = m.x - 1;
+    }
+
+    if (m.y == coord.y) {
+        new_coord.y = m.y;
+    }
+    else if (m.y < coord.y) {
+        new_coord.y = m.y + 1;
+    }
+    else {
+        new_coord.y = m.y - 1;
+    }
+
+    return new_coord;
+}
+
+int allocate_monster_slot(Dungeon * d) {
+    d->number_of_free_monster_slots --;
+    return d->free_monster_slots[d->number_of_free_monster_slots];
+}
+
+void kill_monster_at(Dungeon * d, int index) {
+    struct Monster m = d->monsters[index];
+    d->board.monster[cell_index(d, m.x, m.y)] = NO_MONSTER;
+    d->monsters_killed_by_type[m.decimal_type] ++;
+    cancel_turn(d->turn_scheduler, index + 1);
+    // Bump the generation so stale handles to this slot are ignored.
+    d->monster_generations[index] ++;
+    if (d->monster_generations[index] == 0) {
+        d->monster_generations[index] = 1;
+    }
+    d->free_monster_slots[d->number_of_free_monster_slots] = index;
+    d->number_of_free_monster_slots ++;
+    d->number_of_monsters --;
+}
+
+void kill_player_or_monster_at(Dungeon * d, struct Coordinate coord) {
+    int index = get_monster_index(d, coord);
+    if (index >= 0) {
+        if (d->verbose) {
+            print_message(d, "Monster with ability %d was killed!\n", d->monsters[index].decimal_type);
+        }
+        kill_monster_at(d, index);
+    }
+    if (d->player.x == coord.x && d->player.y == coord.y) {
+        d->player_is_alive = 0;
+        if (d->verbose) {
+            print_message(d, "The player was killed!\n");
+        }
+    }
+}
+
+// The rules every monster type follows, written out plainly against the
+// trait bits. The kernels below must always agree with it; --check_behavior
+// holds them to it on every monster turn.
+struct Monster_Move decide_monster_move(Dungeon * d, int index, Rng * rng) {
+    struct Monster monster = d->monsters[index];
+    int type = monster.decimal_type;
+    struct Coordinate monster_coord;
+    monster_coord.x = monster.x;
+    monster_coord.y = monster.y;
+    struct Monster_Move move;
+    move.to = monster_coord;
+    move.last_known_player_location = monster.last_known_player_location;
+    move.depends_on = DEPENDS_ON_NOTHING_MORE;
+
+    // Half of an erratic monster's turns are a random step, whatever its
+    // other traits.
+    if ((type & TRAIT_ERRATIC) && should_do_erratic_behavior(rng)) {
+        move.to = get_random_new_non_tunneling_location(d, monster_coord, rng);
+        move.depends_on = DEPENDS_ON_OPEN_NEIGHBORS;
+        return move;
+    }
+    // A telepathic monster always knows where the player is. An intelligent
+    // one follows the shortest path for how it moves; the others head
+    // straight at the player.
+    if (type & TRAIT_TELEPATHIC) {
+        int index_on_board = cell_index(d, monster.x, monster.y);
+        if ((type & TRAIT_INTELLIGENT) && (type & TRAIT_TUNNELING)) {
+            move.to = get_cell_for_index(d, get_lowest_neighbor_in_order(d, d->board.tunneling_distance, index_on_board));
+            move.depends_on = DEPENDS_ON_TUNNELING_MAP;
+        }
+        else if (type & TRAIT_INTELLIGENT) {
+            move.to = get_cell_for_index(d, get_lowest_neighbor_in_order(d, d->board.non_tunneling_distance, index_on_board));
+            move.depends_on = DEPENDS_ON_NON_TUNNELING_MAP;
+        }
+        else {
+            move.to = get_straight_path_to(d, index, d->player);
+        }
+        return move;
+    }
+    // Any other monster heads straight at a player it can see, in the same
+    // room. An intelligent one remembers where it last saw the player and
+    // heads there until it arrives.
+    if (monster_is_in_same_room_as_player(d, index)) {
+        if (type & TRAIT_INTELLIGENT) {
+            move.last_known_player_location = d->player;
+        }
+        move.to = get_straight_path_to(d, index, d->player);
+    }
+    else if ((type & TRAIT_INTELLIGENT) && monster_knows_last_player_location(d, index)) {
+        move.to = get_straight_path_to(d, index, monster.last_known_player_location);
+        if (move.to.x == monster.last_known_player_location.x && move.to.y == monster.last_known_player_location.y) {
+            move.last_known_player_location.x = 0;
+            move.last_known_player_location.y = 0;
+        }
+    }
+    else if (type & TRAIT_TUNNELING) {
+        move.to = get_random_new_tunneling_location(d, monster_coord, rng);
+    }
+    else {
+        move.to = get_random_new_non_tunneling_location(d, monster_coord, rng);
+        move.depends_on = DEPENDS_ON_OPEN_NEIGHBORS;
+    }
+    return move;
+}
+
+// The same rules with traits known when it is compiled. Each kernel passes
+// a constant, so inlined into it only the branches its traits need are left.
+static inline struct Monster_Move decide_move_with_traits(Dungeon * d, int index, Rng * rng, const int traits) {
+    struct Monster monster = d->monsters[index];
+    struct Coordinate monster_coord;
+    monster_coord.x = monster.x;
+    monster_coord.y = monster.y;
+    struct Monster_Move move;
+    move.to = monster_coord;
+    move.last_known_player_location = monster.last_known_player_location;
+    move.depends_on = DEPENDS_ON_NOTHING_MORE;
+    if ((traits & TRAIT_ERRATIC) && should_do_erratic_behavior(rng)) {
+        move.to = get_random_new_non_tunneling_location(d, monster_coord, rng);
+        move.depends_on = DEPENDS_ON_OPEN_NEIGHBORS;
+    }
+    else if ((traits & TRAIT_TELEPATHIC) && (traits & TRAIT_INTELLIGENT)) {
+        if (traits & TRAIT_TUNNELING) {
+            move.to = get_cell_on_tunneling_path(d, monster_coord);
+            move.depends_on = DEPENDS_ON_TUNNELING_MAP;
+        }
+        else {
+            move.to = get_cell_on_non_tunneling_path(d, monster_coord);
+            move.depends_on = DEPENDS_ON_NON_TUNNELING_MAP;
+        }
+    }
+    else if ((traits & TRAIT_TELEPATHIC) || monster_is_in_same_room_as_player(d, index)) {
+        if (!(traits & TRAIT_TELEPATHIC) && (traits & TRAIT_INTELLIGENT)) {
+            move.last_known_player_location = d->player;
+        }
+        move.to = get_straight_path_to(d, index, d->player);
+    }
+    else if ((traits & TRAIT_INTELLIGENT) && monster_knows_last_player_location(d, index)) {
+        move.to = get_straight_path_to(d, index, monster.last_known_player_location);
+        if (move.to.x == monster.last_known_player_location.x && move.to.y == monster.last_known_player_location.y) {
+            move.last_known_player_location.x = 0;
+            move.last_known_player_location.y = 0;
+        }
+    }
+    else if (traits & TRAIT_TUNNELING) {
+        move.to = get_random_new_tunneling_location(d, monster_coord, rng);
+    }
+    else {
+        move.to = get_random_new_non_tunneling_location(d, monster_coord, rng);
+        move.depends_on = DEPENDS_ON_OPEN_NEIGHBORS;
+    }
+    return move;
+}
+
+#define MONSTER_KERNEL(traits) \
+    static struct Monster_Move decide_move_##traits(Dungeon * d, int index, Rng * rng) { \
+        return decide_move_with_traits(d, index, rng, traits); \
+    }
+
+MONSTER_KERNEL(0)
+MONSTER_KERNEL(1)
+MONSTER_KERNEL(2)
+MONSTER_KERNEL(3)
+MONSTER_KERNEL(4)
+MONSTER_KERNEL(5)
+MONSTER_KERNEL(6)
+MONSTER_KERNEL(7)
+MONSTER_KERNEL(8)
+MONSTER_KERNEL(9)
+MONSTER_KERNEL(10)
+MONSTER_KERNEL(11)
+MONSTER_KERNEL(12)
+MONSTER_KERNEL(13)
+MONSTER_KERNEL(14)
+MONSTER_KERNEL(15)
+
+// Indexed by decimal_type.
+static const Monster_Kernel MONSTER_KERNELS[NUMBER_OF_MONSTER_TYPES] = {
+    decide_move_0, decide_move_1, decide_move_2, decide_move_3,
+    decide_move_4, decide_move_5, decide_move_6, decide_move_7,
+    decide_move_8, decide_move_9, decide_move_10, decide_move_11,
+    decide_move_12, decide_move_13, decide_move_14, decide_move_15
+};
+
+// Runs the monster's kernel and, with --check_behavior, the reference rules
+// from the same random state, exiting if they pick different moves or draw
+// a different number of random numbers.
+struct Monster_Move decide_move_for_monster(Dungeon * d, int index, Rng * rng) {
+    int type = d->monsters[index].decimal_type;
+    if (!d->check_behavior) {
+        return MONSTER_KERNELS[type](d, index, rng);
+    }
+    Rng expected_rng = *rng;
+    struct Monster_Move expected = decide_monster_move(d, index, &expected_rng);
+    struct Monster_Move move = MONSTER_KERNELS[type](d, index, rng);
+    if (move.to.x != expected.to.x || move.to.y != expected.to.y ||
+            move.last_known_player_location.x != expected.last_known_player_location.x ||
+            move.last_known_player_location.y != expected.last_known_player_location.y ||
+            move.depends_on != expected.depends_on ||
+            memcmp(rng, &expected_rng, sizeof(Rng)) != 0) {
+        struct Monster m = d->monsters[index];
+        printf("Monster of type %d at (%d, %d) moved to (%d, %d) on turn %ld, expected (%d, %d)\n",
+                type, m.x, m.y, move.to.x, move.to.y, d->turns, expected.to.x, expected.to.y);
+        exit(1);
+    }
+    return move;
+}
+
+// Makes a decided move: a tunneling monster wears at the rock it steps into
+// and any other monster stays put rather than step into rock. Whoever was on
+// the cell the monster ends up on is killed.
+void apply_monster_move(Dungeon * d, int index, struct Monster_Move move) {
+    struct Monster monster = d->monsters[index];
+    d->board.monster[cell_index(d, monster.x, monster.y)] = NO_MONSTER;
+    d->monsters[index].last_known_player_location = move.last_known_player_location;
+    int can_enter;
+    if (monster.decimal_type & TRAIT_TUNNELING) {
+        can_enter = tunnel_into_cell_at(d, move.to);
+    }
+    else {
+        can_enter = d->board.hardness[cell_index(d, move.to.x, move.to.y)] == 0;
+    }
+    if (!can_enter) {
+        move.to.x = monster.x;
+        move.to.y = monster.y;
+    }
+    if (move.to.x != monster.x || move.to.y != monster.y) {
+        kill_player_or_monster_at(d, move.to);
+        if (!d->player_is_alive && d->player_killed_by == -1) {
+            d->player_killed_by = monster.decimal_type;
+        }
+    }
+    d->monsters[index].x = move.to.x;
+    d->monsters[index].y = move.to.y;
+    d->board.monster[cell_index(d, move.to.x, move.to.y)] = get_monster_handle(d, index);
+}
+
+void move_monster_at_index(Dungeon * d, int index, Rng * rng) {
+    apply_monster_move(d, index, decide_move_for_monster(d, index, rng));
+}
+
+// One bit per neighbor of the cell, in neighbor_offsets order, set when it
+// is open.
+int get_open_neighbors(Dungeon * d, int index) {
+    int open = 0;
+    for (int i = 0; i < 8; i++) {
+        if (d->board.hardness[index + d->neighbor_offsets[i]] == 0) {
+            open |= 1 << i;
+        }
+    }
+    return open;
+}
+
+// Whether a move decided ahead still holds: it is for this turn of this
+// monster, the player has not moved since, and whatever else the move was
+// decided from is unchanged.
+int decided_move_holds(Dungeon * d, int index, uint64_t tick) {
+    struct Decided_Move decided = d->decided_moves[index];
+    if (decided.tick != tick || decided.handle != get_monster_handle(d, index) ||
+            decided.player_version != d->player_version) {
+        return 0;
+    }
+    struct Monster m = d->monsters[index];
+    switch (decided.move.depends_on) {
+        case DEPENDS_ON_OPEN_NEIGHBORS:
+            return decided.version == (uint64_t) get_open_neighbors(d, cell_index(d, m.x, m.y));
+        case DEPENDS_ON_NON_TUNNELING_MAP:
+            return decided.version == d->open_cells_version;
+        case DEPENDS_ON_TUNNELING_MAP:
+            return decided.version == d->hardness_version;
+        default:
+            return 1;
+    }
+}
+
+// Notes what a move decided ahead was decided from.
+void record_decided_move(Dungeon * d, int index, uint64_t tick, struct Monster_Move move) {
+    struct Decided_Move * decided = &d->decided_moves[index];
+    struct Monster m = d->monsters[index];
+    decided->move = move;
+    decided->handle = get_monster_handle(d, index);
+    decided->tick = tick;
+    decided->player_version = d->player_version;
+    switch (move.depends_on) {
+        case DEPENDS_ON_OPEN_NEIGHBORS:
+            decided->version = get_open_neighbors(d, cell_index(d, m.x, m.y));
+            break;
+        case DEPENDS_ON_NON_TUNNELING_MAP:
+            decided->version = d->open_cells_version;
+            break;
+        case DEPENDS_ON_TUNNELING_MAP:
+            decided->version = d->hardness_version;
+            break;
+        default:
+            decided->version = 0;
+            break;
+    }
+}
+
+// Makes room for a move decided ahead for every monster slot, none of them
+// decided yet. Done whenever the monster pool is made, since the turn pool
+// is sized to it.
+void reset_decided_moves(Dungeon * d) {
+    free(d->decided_moves);
+    if (d->turn_pool) {
+        free_turn_pool(d->turn_pool);
+        d->turn_pool = NULL;
+    }
+    d->decided_moves = calloc(d->monster_pool_size, sizeof(struct Decided_Move));
+    d->decided_tick = UINT64_MAX;
+}
+
+// The move decided ahead for this turn when it still holds, or else a move
+// decided now from the turn's generator, which is the one the move ahead
+// was decided from.
+struct Monster_Move get_move_for_turn(Dungeon * d, int index, uint64_t tick, Rng * rng) {
+    if (decided_move_holds(d, index, tick)) {
+        return d->decided_moves[index].move;
+    }
+    return decide_move_for_monster(d, index, rng);
+}
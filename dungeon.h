@@ -0,0 +1,414 @@
+#include <stdint.h>
+
+#include "priority_queue.h"
+#include "bucket_queue.h"
+#include "scheduler.h"
+#include "rng.h"
+
+#define DEFAULT_HEIGHT 105
+#define DEFAULT_WIDTH 160
+// Room fields and coordinates are 16-bit; 4096 keeps every plane index in
+// an int.
+#define MAX_MAP_SIZE 4096
+#define MIN_MAP_WIDTH (DEFAULT_MAX_ROOM_WIDTH + 3)
+#define MIN_MAP_HEIGHT (DEFAULT_MAX_ROOM_HEIGHT + 3)
+#define IMMUTABLE_ROCK 255
+#define ROCK 200
+#define ROOM 0
+#define CORRIDOR 0
+#define MIN_NUMBER_OF_ROOMS 10
+#define MAX_NUMBER_OF_ROOMS 50
+#define MIN_ROOM_WIDTH 7
+#define DEFAULT_MAX_ROOM_WIDTH 15
+#define MIN_ROOM_HEIGHT 5
+#define DEFAULT_MAX_ROOM_HEIGHT 10
+// Random rooms tried before falling back to the smallest room that fits.
+#define ROOM_PLACEMENT_ATTEMPTS 64
+#define DEFAULT_NUMBER_OF_MONSTERS 5
+#define MAX_TUNNELING_WEIGHT 3
+// Monsters due on one tick before their moves are decided ahead on the
+// turn pool, when there is one.
+#define MIN_TURNS_TO_DECIDE_AHEAD 32
+// Smallest map whose distance maps are computed on the path pool, when
+// there is one. Smaller maps have too few cells per level to share out.
+#define MIN_CELLS_FOR_PATH_THREADS 65536
+
+#define NUMBER_OF_MONSTER_TYPES 16
+// Bits of a monster's decimal_type.
+#define TRAIT_INTELLIGENT 1
+#define TRAIT_TELEPATHIC 2
+#define TRAIT_TUNNELING 4
+#define TRAIT_ERRATIC 8
+#define RLG_DIRECTORY_NAME "/.rlg327/"
+#define DUNGEON_FILE_NAME "dungeon"
+#define DUNGEON_FILE_MARKER "RLG327-S2017"
+#define DUNGEON_MARKER_SIZE 12
+#define DUNGEON_HEADER_SIZE 20
+#define DUNGEON_V1_META_SIZE 10
+// Worst case size of the version 1 hardness runs, when single open and rock
+// cells alternate: three bytes for every two cells.
+#define HARDNESS_RUNS_MAX_SIZE(cells) ((cells) * 2 + 8)
+#define PACK_FILE_MARKER "RLG327-PACK0"
+#define PACK_ENTRY_SIZE 26
+#define PACK_FOOTER_SIZE 24
+#define SNAPSHOT_FILE_MARKER "RLG327-SNAP0"
+#define DISTANCE_CACHE_FILE_NAME "dungeon.distances"
+#define DISTANCE_CACHE_FILE_MARKER "RLG327-DIST0"
+#define NO_MONSTER 0
+// Scheduler entity ids: the player is 0 and monster slot i is i + 1.
+#define PLAYER_ENTITY 0
+#define MONSTER_SLOT_BITS 24
+#define MONSTER_SLOT_MASK ((1 << MONSTER_SLOT_BITS) - 1)
+#define UNREACHABLE_TUNNELING UINT32_MAX
+#define UNREACHABLE_NON_TUNNELING UINT32_MAX
+
+// Each subsystem draws from its own stream so that, for a given seed, changing
+// how often one of them rolls does not shift the others.
+enum Rng_Stream {
+    STREAM_TERRAIN,
+    STREAM_ROOMS,
+    STREAM_CORRIDORS,
+    STREAM_SPAWN,
+    STREAM_MOVEMENT,
+    NUMBER_OF_STREAMS
+};
+
+enum Cell_Type {
+    TYPE_ROCK,
+    TYPE_ROOM,
+    TYPE_CORRIDOR
+};
+
+// A handle is a monster's pool slot plus the generation of that slot, so it
+// stays valid while the monster lives and is recognizably stale once it dies.
+typedef uint32_t Monster_Handle;
+
+struct Monster {
+    uint16_t x;
+    uint16_t y;
+    uint8_t decimal_type;
+    struct Coordinate last_known_player_location;
+    uint8_t speed;
+};
+
+// What a monster's move was decided from, besides the monster itself and
+// the player.
+enum Move_Dependency {
+    DEPENDS_ON_NOTHING_MORE,
+    DEPENDS_ON_OPEN_NEIGHBORS,
+    DEPENDS_ON_NON_TUNNELING_MAP,
+    DEPENDS_ON_TUNNELING_MAP
+};
+
+// Where a monster steps on its turn and what it remembers of the player
+// afterwards. Deciding a move only reads the board and rolls from the
+// turn's generator; tunneling and killing happen when it is applied.
+struct Monster_Move {
+    struct Coordinate to;
+    struct Coordinate last_known_player_location;
+    int depends_on;
+};
+
+// A move decided ahead of its turn. It is made as decided only if the turn
+// is still the one it was decided for and nothing it was decided from has
+// changed since; otherwise the move is decided again on its turn. version
+// is the open neighbors or the map version the move depended on.
+struct Decided_Move {
+    struct Monster_Move move;
+    Monster_Handle handle;
+    uint64_t tick;
+    uint64_t player_version;
+    uint64_t version;
+};
+
+struct Turn_Pool;
+struct Path_Pool;
+
+struct Available_Coords {
+    struct Coordinate coords[8];
+    int length;
+};
+
+// The board is kept as one dense plane per field, indexed by cell_index, so
+// the distance and movement loops only touch the bytes they need. Each plane
+// holds width * height cells of the dungeon it belongs to.
+struct Board {
+    uint8_t * hardness;
+    uint8_t * type;
+    uint32_t * tunneling_distance;
+    uint32_t * non_tunneling_distance;
+    Monster_Handle * monster;
+};
+
+
+struct Room {
+    uint16_t start_x;
+    uint16_t end_x;
+    uint16_t start_y;
+    uint16_t end_y;
+};
+
+// Everything one game needs. Nothing in the engine touches global state, so
+// any number of dungeons can be played side by side in one process.
+typedef struct {
+    int width;
+    int height;
+    // Offsets of the eight neighbors of a cell in the board planes. The
+    // outer ring of the board is immutable rock, so every cell that is not
+    // immutable rock has all eight neighbors on the board and loops over
+    // these need no bounds checks.
+    int neighbor_offsets[8];
+    struct Board board;
+    struct Coordinate * placeable_areas;
+    int number_of_placeable_areas;
+    struct Room * rooms;
+    int number_of_rooms;
+    int max_room_width;
+    int max_room_height;
+    // One bit per cell that is in a room or next to one, while digging rooms,
+    // in rows of room_occupancy_words words.
+    uint64_t * room_occupancy;
+    int room_occupancy_words;
+    struct Monster * monsters;
+    uint8_t * monster_generations;
+    int * free_monster_slots;
+    int number_of_monsters;
+    int monster_pool_size;
+    int number_of_free_monster_slots;
+    struct Coordinate player;
+    struct Room player_room;
+    int player_is_alive;
+    long turns;
+    // Stop the game after this many turns; 0 plays until someone wins.
+    long max_turns;
+    int monsters_spawned_by_type[NUMBER_OF_MONSTER_TYPES];
+    int monsters_killed_by_type[NUMBER_OF_MONSTER_TYPES];
+    // Type of the monster that killed the player, or -1.
+    int player_killed_by;
+    char * rlg_directory;
+    Scheduler * turn_scheduler;
+    // Threads deciding monster moves ahead of their turns; 1 decides every
+    // move on its turn.
+    int turn_threads;
+    struct Turn_Pool * turn_pool;
+    // By monster slot, for the turns due on decided_tick.
+    struct Decided_Move * decided_moves;
+    uint64_t decided_tick;
+    // Bumped whenever the player moves, tunneling wears down rock, and a
+    // cell opens, respectively.
+    uint64_t player_version;
+    uint64_t hardness_version;
+    uint64_t open_cells_version;
+    // Threads computing each distance map from the player level by level;
+    // 1 computes them on the thread playing the game.
+    int path_threads;
+    struct Path_Pool * path_pool;
+    Rng rng_streams[NUMBER_OF_STREAMS];
+    // Only made for the heap-based Dijkstra.
+    Queue * distance_queue;
+    Bucket_Queue * tunneling_buckets;
+    int * non_tunneling_frontier;
+    // Made on the first frame. Worst case is an incremental frame where
+    // every cell moves the cursor.
+    char * frame_buffer;
+    char * frame_glyphs;
+    // Cleared by print_message, so the next frame is drawn in full.
+    int frame_is_drawn;
+    int incremental_rendering;
+    int use_heap_pathing;
+    int check_pathing;
+    int check_behavior;
+    // Keep the first distance maps in a cache beside the saved dungeon.
+    int cache_distances;
+    int verbose;
+} Dungeon;
+
+// One dungeon in a pack. offset and length locate a complete dungeon file;
+// the rest is metadata for choosing dungeons without loading them. seed is
+// 0 when the dungeon was not generated by this program.
+typedef struct {
+    uint64_t offset;
+    uint32_t length;
+    int number_of_rooms;
+    int open_cells;
+    uint64_t seed;
+} Pack_Entry;
+
+// A pack file mapped read-only. Dungeons are appended one after another,
+// followed by an index of fixed size entries and a footer pointing at it:
+//   entry: u64 offset, u32 length, u16 rooms, u32 open cells, u64 seed
+//   footer: u64 index offset, u32 number of entries, PACK_FILE_MARKER
+// All values are big-endian.
+typedef struct {
+    char * path;
+    uint8_t * bytes;
+    long size;
+    uint8_t * index;
+    int number_of_entries;
+} Pack;
+
+// A snapshot file read into memory. It can be restored into any number of
+// dungeons.
+typedef struct {
+    char * path;
+    uint8_t * bytes;
+    long size;
+} Snapshot;
+
+// Settings shared by every game in a batch. Each game gets its own Dungeon
+// seeded from seed and its index.
+typedef struct {
+    int games;
+    int threads;
+    uint64_t seed;
+    long max_turns;
+    // Size of generated dungeons; loaded ones keep their own.
+    int width;
+    int height;
+    int number_of_rooms;
+    int number_of_monsters;
+    int load;
+    // When set, game i plays entry i of the pack, wrapping around.
+    Pack * pack;
+    // When set, every game continues from the snapshot, reseeded with its
+    // own seed.
+    Snapshot * snapshot;
+    struct Coordinate player;
+    int use_heap_pathing;
+    int check_behavior;
+    int cache_distances;
+    int turn_threads;
+    int path_threads;
+} Batch_Config;
+
+typedef struct {
+    int games;
+    int threads;
+    int wins;
+    int losses;
+    int unfinished;
+    long total_turns;
+    long min_turns;
+    long max_turns;
+    long monsters_spawned_by_type[NUMBER_OF_MONSTER_TYPES];
+    long monsters_killed_by_type[NUMBER_OF_MONSTER_TYPES];
+    long player_kills_by_type[NUMBER_OF_MONSTER_TYPES];
+    double seconds;
+} Batch_Result;
+
+typedef struct Monster_Move (*Monster_Kernel)(Dungeon * d, int index, Rng * rng);
+
+static inline int cell_index(Dungeon * d, int x, int y) {
+    return (y * d->width) + x;
+}
+
+Dungeon * create_new_dungeon();
+void free_dungeon(Dungeon * d);
+void set_dungeon_size(Dungeon * d, int width, int height);
+void set_dungeon_size_from_file(Dungeon * d, long width, long height, char * name);
+int get_max_number_of_rooms(Dungeon * d);
+void generate_dungeon(Dungeon * d);
+void start_game(Dungeon * d);
+int play_turn(Dungeon * d);
+int game_is_over(Dungeon * d);
+uint64_t get_game_seed(uint64_t seed, int game);
+Batch_Result run_batch(Batch_Config config);
+void print_batch_result(Batch_Result result);
+Pack * open_pack(char * path);
+void close_pack(Pack * p);
+Pack_Entry get_pack_entry(Pack * p, int index);
+void load_board_from_pack(Dungeon * d, Pack * p, int index);
+int append_to_pack(Dungeon * d, char * path, int version, uint64_t seed);
+int save_snapshot(Dungeon * d, char * path);
+Snapshot * read_snapshot(char * path);
+void free_snapshot(Snapshot * s);
+void restore_snapshot(Dungeon * d, Snapshot * s);
+void make_rlg_directory(Dungeon * d);
+void get_dungeon_path(Dungeon * d, char * path, int size);
+void update_number_of_rooms(Dungeon * d);
+int random_int(Dungeon * d, int min_num, int max_num, enum Rng_Stream stream);
+int random_int_from(Rng * rng, int min_num, int max_num);
+void seed_turn_rng(Dungeon * d, Rng * rng, uint64_t tick, int entity);
+void seed_random_streams(Dungeon * d, uint64_t seed);
+void initialize_board(Dungeon * d);
+void initialize_immutable_rock(Dungeon * d);
+void load_board(Dungeon * d);
+void fill_dungeon_header(uint8_t * header, uint32_t version, uint32_t file_size);
+void save_board(Dungeon * d, int version);
+int save_board_version_0(Dungeon * d, int fd);
+int save_board_version_1(Dungeon * d, int fd);
+int encode_hardness_runs(Dungeon * d, uint8_t * out);
+int decode_hardness_runs(Dungeon * d, const uint8_t * in, int length);
+void load_board_from_memory(Dungeon * d, const uint8_t * bytes, long size, char * name);
+int check_dungeon_header(Dungeon * d, const uint8_t * header, long size, char * name);
+void set_cell_types_from_hardness(Dungeon * d);
+void finish_loading_board(Dungeon * d);
+int check_version_0_size(int body_size, char * name);
+void load_board_version_0(Dungeon * d, int fd, int body_size, char * filepath);
+void read_rooms_version_0(Dungeon * d, const uint8_t * room_bytes, int rooms_size, char * name);
+void decode_board_version_1(Dungeon * d, const uint8_t * body, int body_size, char * name);
+void allocate_rooms_from_file(Dungeon * d, int number_of_rooms, char * name);
+void set_room_from_file(Dungeon * d, int index, int x, int y, int width, int height, char * name);
+uint64_t hash_hardness(Dungeon * d);
+void get_distance_cache_path(Dungeon * d, char * path, int size);
+int load_distance_cache(Dungeon * d);
+void save_distance_cache(Dungeon * d);
+void place_player(Dungeon * d);
+void set_placeable_areas(Dungeon * d);
+int get_cell_weight(int hardness);
+int should_use_path_threads(Dungeon * d);
+void set_tunneling_distance_to_player(Dungeon * d);
+void make_distance_queue(Dungeon * d);
+void set_tunneling_distance_with_heap(Dungeon * d);
+void set_tunneling_distance_with_buckets(Dungeon * d);
+void set_non_tunneling_distance_to_player(Dungeon * d);
+void set_non_tunneling_distance_with_heap(Dungeon * d);
+void set_non_tunneling_distance_with_bfs(Dungeon * d);
+void check_distance_maps(Dungeon * d, char * after);
+void relax_tunneling_distances(Dungeon * d);
+void relax_non_tunneling_distances(Dungeon * d, int frontier_length);
+int tunnel_into_cell_at(Dungeon * d, struct Coordinate coord);
+void generate_monsters(Dungeon * d);
+void print_non_tunneling_board(Dungeon * d);
+void print_tunneling_board(Dungeon * d);
+void print_board(Dungeon * d);
+void print_message(Dungeon * d, const char * format, ...);
+char get_cell_glyph(Dungeon * d, int index);
+void dig_rooms(Dungeon * d, int number_of_rooms_to_dig);
+int dig_room(Dungeon * d, int index);
+int dig_smallest_room(Dungeon * d, int index);
+int room_is_free(Dungeon * d, struct Room room);
+void place_room(Dungeon * d, int index, struct Room room);
+void add_rooms_to_board(Dungeon * d);
+void dig_cooridors(Dungeon * d);
+void connect_rooms_at_indexes(Dungeon * d, int index1, int index2);
+int get_monster_index(Dungeon * d, struct Coordinate coord);
+Monster_Handle get_monster_handle(Dungeon * d, int index);
+int get_monster_index_for_handle(Dungeon * d, Monster_Handle handle);
+int allocate_monster_slot(Dungeon * d);
+void update_player_room(Dungeon * d);
+void move_player(Dungeon * d, Rng * rng);
+struct Coordinate get_cell_for_index(Dungeon * d, int index);
+int get_lowest_neighbor_in_order(Dungeon * d, const uint32_t * distances, int index);
+int get_lowest_neighbor(Dungeon * d, const uint32_t * distances, int index);
+void get_lowest_neighbors(Dungeon * d, const uint32_t * distances, const int * indexes, int * lowest, int count);
+struct Coordinate get_cell_on_tunneling_path(Dungeon * d, struct Coordinate c);
+struct Coordinate get_cell_on_non_tunneling_path(Dungeon * d, struct Coordinate c);
+struct Monster_Move decide_monster_move(Dungeon * d, int index, Rng * rng);
+struct Monster_Move decide_move_for_monster(Dungeon * d, int index, Rng * rng);
+void apply_monster_move(Dungeon * d, int index, struct Monster_Move move);
+void move_monster_at_index(Dungeon * d, int index, Rng * rng);
+int get_open_neighbors(Dungeon * d, int index);
+int decided_move_holds(Dungeon * d, int index, uint64_t tick);
+void record_decided_move(Dungeon * d, int index, uint64_t tick, struct Monster_Move move);
+void reset_decided_moves(Dungeon * d);
+struct Monster_Move get_move_for_turn(Dungeon * d, int index, uint64_t tick, Rng * rng);
+struct Turn_Pool * create_turn_pool(Dungeon * d);
+void free_turn_pool(struct Turn_Pool * pool);
+void decide_move_ahead(Dungeon * d, int entity, uint64_t tick);
+void decide_turns_ahead(Dungeon * d, int entity, uint64_t tick);
+struct Path_Pool * create_path_pool(Dungeon * d);
+void free_path_pool(struct Path_Pool * pool);
+void set_tunneling_distance_in_parallel(Dungeon * d);
+void set_non_tunneling_distance_in_parallel(Dungeon * d);
+void kill_player_or_monster_at(Dungeon * d, struct Coordinate coord);
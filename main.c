@@ -0,0 +1,329 @@
+#include <stdint.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "dungeon.h"
+
+#define DEFAULT_FRAMES_PER_SECOND 12
+#define DEFAULT_BATCH_MAX_TURNS 100000
+
+int DO_SAVE = 0;
+int DO_LOAD = 0;
+int SHOW_HELP = 0;
+int HEADLESS = 0;
+int RENDER_EVERY = 1;
+int FRAMES_PER_SECOND = DEFAULT_FRAMES_PER_SECOND;
+int BATCH_GAMES = 0;
+int BATCH_THREADS = 0;
+long MAX_TURNS = -1;
+int SAVE_VERSION = 0;
+int CACHE_DISTANCES = 0;
+char * PACK_PATH = NULL;
+int PACK_INDEX = 0;
+char * SNAPSHOT_PATH = NULL;
+char * RESUME_PATH = NULL;
+
+void print_usage();
+void run_batch_and_report(Dungeon * d, uint64_t seed);
+
+int main(int argc, char *args[]) {
+    Dungeon * d = create_new_dungeon();
+    int player_x = -1;
+    int player_y = -1;
+    int width = DEFAULT_WIDTH;
+    int height = DEFAULT_HEIGHT;
+    struct option longopts[] = {
+        {"save", no_argument, &DO_SAVE, 1},
+        {"load", no_argument, &DO_LOAD, 1},
+        {"heap_pathing", no_argument, &d->use_heap_pathing, 1},
+        {"check_pathing", no_argument, &d->check_pathing, 1},
+        {"check_behavior", no_argument, &d->check_behavior, 1},
+        {"cache_distances", no_argument, &CACHE_DISTANCES, 1},
+        {"headless", no_argument, &HEADLESS, 1},
+        {"incremental", no_argument, &d->incremental_rendering, 1},
+        {"rooms", required_argument, 0, 'r'},
+        {"nummon", required_argument, 0, 'm'},
+        {"player_x", required_argument, 0, 'x'},
+        {"player_y", required_argument, 0, 'y'},
+        {"seed", required_argument, 0, 's'},
+        {"render_every", required_argument, 0, 'e'},
+        {"fps", required_argument, 0, 'f'},
+        {"batch", required_argument, 0, 'b'},
+        {"threads", required_argument, 0, 't'},
+        {"turn_threads", required_argument, 0, 'T'},
+        {"path_threads", required_argument, 0, 'P'},
+        {"max_turns", required_argument, 0, 'n'},
+        {"save_version", required_argument, 0, 'v'},
+        {"width", required_argument, 0, 'W'},
+        {"height", required_argument, 0, 'H'},
+        {"pack", required_argument, 0, 'p'},
+        {"index", required_argument, 0, 'i'},
+        {"snapshot", required_argument, 0, 'c'},
+        {"resume", required_argument, 0, 'u'},
+        {"help", no_argument, &SHOW_HELP, 'h'},
+        {0, 0, 0, 0}
+    };
+    uint64_t seed = time(NULL);
+    int c;
+    while((c = getopt_long(argc, args, "h:", longopts, NULL)) != -1) {
+        switch(c) {
+            case 'r':
+                d->number_of_rooms = atoi(optarg);
+                break;
+            case 'm':
+                d->number_of_monsters =  atoi(optarg);
+                if (d->number_of_monsters < 1) {
+                    d->number_of_monsters = DEFAULT_NUMBER_OF_MONSTERS;
+                    printf("Number of monsters cannot be less than 1\n");
+                }
+                break;
+            case 'x':
+                player_x = atoi(optarg);
+                break;
+            case 'y':
+                player_y = atoi(optarg);
+                break;
+            case 's':
+                seed = strtoull(optarg, NULL, 10);
+                break;
+            case 'e':
+                RENDER_EVERY = atoi(optarg);
+                if (RENDER_EVERY < 1) {
+                    RENDER_EVERY = 1;
+                    printf("Can only render every 1 or more player turns\n");
+                }
+                break;
+            case 'f':
+                FRAMES_PER_SECOND = atoi(optarg);
+                if (FRAMES_PER_SECOND < 0) {
+                    FRAMES_PER_SECOND = DEFAULT_FRAMES_PER_SECOND;
+                    printf("Frames per second cannot be negative\n");
+                }
+                break;
+            case 'b':
+                BATCH_GAMES = atoi(optarg);
+                break;
+            case 't':
+                BATCH_THREADS = atoi(optarg);
+                break;
+            case 'T':
+                d->turn_threads = atoi(optarg);
+                if (d->turn_threads < 1) {
+                    d->turn_threads = 1;
+                    printf("Turn threads has to be at least 1\n");
+                }
+                break;
+            case 'P':
+                d->path_threads = atoi(optarg);
+                if (d->path_threads < 1) {
+                    d->path_threads = 1;
+                    printf("Path threads has to be at least 1\n");
+                }
+                break;
+            case 'n':
+                MAX_TURNS = atol(optarg);
+                break;
+            case 'v':
+                SAVE_VERSION = atoi(optarg);
+                if (SAVE_VERSION != 0 && SAVE_VERSION != 1) {
+                    SAVE_VERSION = 0;
+                    printf("Dungeons can only be saved as version 0 or 1\n");
+                }
+                break;
+            case 'W':
+                width = atoi(optarg);
+                if (width < MIN_MAP_WIDTH || width > MAX_MAP_SIZE) {
+                    width = DEFAULT_WIDTH;
+                    printf("Width has to be between %d and %d\n", MIN_MAP_WIDTH, MAX_MAP_SIZE);
+                }
+                break;
+            case 'H':
+                height = atoi(optarg);
+                if (height < MIN_MAP_HEIGHT || height > MAX_MAP_SIZE) {
+                    height = DEFAULT_HEIGHT;
+                    printf("Height has to be between %d and %d\n", MIN_MAP_HEIGHT, MAX_MAP_SIZE);
+                }
+                break;
+            case 'p':
+                PACK_PATH = optarg;
+                break;
+            case 'i':
+                PACK_INDEX = atoi(optarg);
+                break;
+            case 'c':
+                SNAPSHOT_PATH = optarg;
+                break;
+            case 'u':
+                RESUME_PATH = optarg;
+                break;
+            case 'h':
+                SHOW_HELP = 1;
+                break;
+            default:
+                break;
+        }
+    }
+    if (SHOW_HELP) {
+        print_usage();
+        exit(0);
+    }
+    set_dungeon_size(d, width, height);
+    if ((player_x != -1 || player_y != -1) && ((player_x <= 0 || player_x > width - 1) || (player_y <= 0 || player_y > height - 1))) {
+        printf("Invalid player coordinates. Note: both player_x and player_y must be provided as inputs\n");
+        print_usage();
+        exit(0);
+    }
+    if (player_y == -1) {
+        player_y = 0;
+    }
+    if (player_x == -1) {
+        player_x = 0;
+    }
+    d->player.x = player_x;
+    d->player.y = player_y;
+    printf("Received Parameters: Save: %d, Load: %d, #Rooms: %d, #NumMon: %d, Seed: %llu\n\n", DO_SAVE, DO_LOAD, d->number_of_rooms, d->number_of_monsters, (unsigned long long) seed);
+    seed_random_streams(d, seed);
+    update_number_of_rooms(d);
+    if (BATCH_GAMES > 0) {
+        run_batch_and_report(d, seed);
+        free_dungeon(d);
+        return 0;
+    }
+    if (MAX_TURNS > 0) {
+        d->max_turns = MAX_TURNS;
+    }
+    make_rlg_directory(d);
+
+    // The seed recorded with a dungeon appended to a pack. A dungeon loaded
+    // from a file was not generated from this run's seed.
+    uint64_t dungeon_seed = seed;
+    if (RESUME_PATH != NULL) {
+        Snapshot * snapshot = read_snapshot(RESUME_PATH);
+        restore_snapshot(d, snapshot);
+        free_snapshot(snapshot);
+        dungeon_seed = 0;
+        printf("Resumed after %ld turns\n", d->turns);
+    }
+    else if (DO_LOAD && PACK_PATH != NULL) {
+        Pack * pack = open_pack(PACK_PATH);
+        load_board_from_pack(d, pack, PACK_INDEX);
+        dungeon_seed = get_pack_entry(pack, PACK_INDEX).seed;
+        close_pack(pack);
+    }
+    else if (DO_LOAD) {
+        load_board(d);
+        d->cache_distances = CACHE_DISTANCES;
+        dungeon_seed = 0;
+    }
+    else {
+        printf("Generating dungeon... \n");
+        printf("Making %d rooms.\n", d->number_of_rooms);
+        generate_dungeon(d);
+    }
+    if (RESUME_PATH == NULL) {
+        start_game(d);
+    }
+    if (!HEADLESS) {
+        print_board(d);
+    }
+    print_message(d, "Player location: (%d, %d) (x, y)\n", d->player.x, d->player.y);
+    int player_turns = 0;
+    while(!game_is_over(d)) {
+        if (play_turn(d) != PLAYER_ENTITY) {
+            continue;
+        }
+        player_turns ++;
+        if (!HEADLESS && player_turns % RENDER_EVERY == 0) {
+            print_board(d);
+            // An fps of 0 renders as fast as the game runs.
+            if (FRAMES_PER_SECOND) {
+                usleep(1000000 / FRAMES_PER_SECOND);
+            }
+        }
+    }
+
+    if (!d->player_is_alive) {
+        printf("You lost. The monsters killed you\n");
+    }
+    else if(!d->number_of_monsters) {
+        printf("You won, killing all the monsters\n");
+    }
+    else {
+        printf("Stopped after %ld turns\n", d->turns);
+    }
+
+    if (DO_SAVE && SAVE_VERSION == 0 && (d->width != DEFAULT_WIDTH || d->height != DEFAULT_HEIGHT)) {
+        printf("Version 0 only holds %dx%d dungeons, so saving as version 1\n", DEFAULT_WIDTH, DEFAULT_HEIGHT);
+        SAVE_VERSION = 1;
+    }
+    if (DO_SAVE && PACK_PATH != NULL) {
+        int index = append_to_pack(d, PACK_PATH, SAVE_VERSION, dungeon_seed);
+        printf("Saved dungeon %d of %s\n", index, PACK_PATH);
+    }
+    else if (DO_SAVE) {
+        save_board(d, SAVE_VERSION);
+    }
+
+    if (SNAPSHOT_PATH != NULL) {
+        if (save_snapshot(d, SNAPSHOT_PATH)) {
+            printf("Saved snapshot to: %s\n", SNAPSHOT_PATH);
+        }
+        else {
+            printf("Cannot save snapshot\n");
+        }
+    }
+
+    free_dungeon(d);
+    return 0;
+}
+
+void print_usage() {
+    printf("usage: generate_dungeon [--save] [--load] [--rooms=<number of rooms>] [--player_x=<player x position>] [--player_y=<player y position>] [--nummon=<number of monsters>] [--seed=<seed>] [--headless] [--incremental] [--render_every=<player turns>] [--fps=<frames per second>] [--batch=<games>] [--threads=<threads>] [--turn_threads=<threads>] [--path_threads=<threads>] [--max_turns=<turns>] [--save_version=<0|1>] [--width=<width>] [--height=<height>] [--pack=<path>] [--index=<dungeon>] [--snapshot=<path>] [--resume=<path>] [--cache_distances] [--heap_pathing] [--check_pathing] [--check_behavior]\n");
+}
+
+// Plays BATCH_GAMES games with the settings parsed into d.
+void run_batch_and_report(Dungeon * d, uint64_t seed) {
+    Batch_Config config;
+    config.games = BATCH_GAMES;
+    config.threads = BATCH_THREADS;
+    if (config.threads < 1) {
+        config.threads = sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if (config.threads < 1) {
+        config.threads = 1;
+    }
+    config.seed = seed;
+    config.max_turns = MAX_TURNS;
+    if (config.max_turns < 0) {
+        config.max_turns = DEFAULT_BATCH_MAX_TURNS;
+    }
+    config.width = d->width;
+    config.height = d->height;
+    config.number_of_rooms = d->number_of_rooms;
+    config.number_of_monsters = d->number_of_monsters;
+    config.load = DO_LOAD;
+    config.pack = NULL;
+    if (DO_LOAD && PACK_PATH != NULL) {
+        config.pack = open_pack(PACK_PATH);
+    }
+    config.snapshot = NULL;
+    if (RESUME_PATH != NULL) {
+        config.snapshot = read_snapshot(RESUME_PATH);
+    }
+    config.player = d->player;
+    config.use_heap_pathing = d->use_heap_pathing;
+    config.check_behavior = d->check_behavior;
+    config.turn_threads = d->turn_threads;
+    config.path_threads = d->path_threads;
+    config.cache_distances = CACHE_DISTANCES;
+    print_batch_result(run_batch(config));
+    if (config.pack != NULL) {
+        close_pack(config.pack);
+    }
+    if (config.snapshot != NULL) {
+        free_snapshot(config.snapshot);
+    }
+}
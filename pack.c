@@ -0,0 +1,190 @@
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "dungeon.h"
+
+void put_big_endian(uint8_t * bytes, uint64_t value, int size) {
+    for (int i = size - 1; i >= 0; i--) {
+        bytes[i] = value & 0xff;
+        value >>= 8;
+    }
+}
+
+uint64_t get_big_endian(const uint8_t * bytes, int size) {
+    uint64_t value = 0;
+    for (int i = 0; i < size; i++) {
+        value = (value << 8) | bytes[i];
+    }
+    return value;
+}
+
+// Reads the index offset and entry count from a pack footer, exiting if
+// the footer does not describe a pack of the given size, which is at least
+// PACK_FOOTER_SIZE. Both fields are untrusted, so nothing is added up until
+// it is known not to overflow.
+void read_pack_footer(const uint8_t * footer, long size, char * path, uint64_t * index_offset, int * number_of_entries) {
+    if (memcmp(footer + 12, PACK_FILE_MARKER, DUNGEON_MARKER_SIZE) != 0) {
+        printf("'%s' is not a dungeon pack\n", path);
+        exit(1);
+    }
+    uint64_t offset = get_big_endian(footer, 8);
+    uint64_t entries = get_big_endian(footer + 8, 4);
+    uint64_t before_footer = size - PACK_FOOTER_SIZE;
+    if (entries > INT_MAX || offset > before_footer || before_footer - offset != entries * PACK_ENTRY_SIZE) {
+        printf("The index of '%s' does not match its size\n", path);
+        exit(1);
+    }
+    *index_offset = offset;
+    *number_of_entries = entries;
+}
+
+// Maps a pack and checks its footer. Every lookup after this is a read from
+// the mapping.
+Pack * open_pack(char * path) {
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        printf("Cannot open pack '%s'\n", path);
+        exit(1);
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) == -1 || file_stat.st_size < PACK_FOOTER_SIZE) {
+        printf("'%s' is too short to be a dungeon pack\n", path);
+        exit(1);
+    }
+    uint8_t * bytes = mmap(NULL, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (bytes == MAP_FAILED) {
+        printf("Cannot map pack '%s'\n", path);
+        exit(1);
+    }
+
+    Pack * p = malloc(sizeof(Pack));
+    p->path = path;
+    p->bytes = bytes;
+    p->size = file_stat.st_size;
+    uint64_t index_offset;
+    read_pack_footer(bytes + p->size - PACK_FOOTER_SIZE, p->size, path, &index_offset, &p->number_of_entries);
+    p->index = bytes + index_offset;
+    if (p->number_of_entries == 0) {
+        printf("'%s' has no dungeons\n", path);
+        exit(1);
+    }
+    return p;
+}
+
+void close_pack(Pack * p) {
+    munmap(p->bytes, p->size);
+    free(p);
+}
+
+Pack_Entry get_pack_entry(Pack * p, int index) {
+    if (index < 0 || index >= p->number_of_entries) {
+        printf("'%s' has %d dungeons, so there is no dungeon %d\n", p->path, p->number_of_entries, index);
+        exit(1);
+    }
+    const uint8_t * fields = p->index + ((long) index * PACK_ENTRY_SIZE);
+    Pack_Entry entry;
+    entry.offset = get_big_endian(fields, 8);
+    entry.length = get_big_endian(fields + 8, 4);
+    entry.number_of_rooms = get_big_endian(fields + 12, 2);
+    entry.open_cells = get_big_endian(fields + 14, 4);
+    entry.seed = get_big_endian(fields + 18, 8);
+    uint64_t dungeons_size = p->index - p->bytes;
+    if (entry.offset > dungeons_size || entry.length > dungeons_size - entry.offset) {
+        printf("Dungeon %d of '%s' is outside the pack\n", index, p->path);
+        exit(1);
+    }
+    return entry;
+}
+
+void load_board_from_pack(Dungeon * d, Pack * p, int index) {
+    Pack_Entry entry = get_pack_entry(p, index);
+    char name[PATH_MAX + 16];
+    snprintf(name, sizeof(name), "%s#%d", p->path, index);
+    if (d->verbose) {
+        printf("Loading dungeon: %s\n", name);
+    }
+    load_board_from_memory(d, p->bytes + entry.offset, entry.length, name);
+}
+
+// Appends in place. The old index and footer are cut off first, then the
+// new dungeon is written where the index started, followed by the index
+// with the new entry. The footer is written last, once the rest is on disk,
+// so an interrupted append leaves a pack without a valid footer, which
+// open_pack refuses, and the dungeons before it untouched. Creates the pack
+// if it does not exist. Returns the index of the new entry.
+int append_to_pack(Dungeon * d, char * path, int version, uint64_t seed) {
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    struct stat file_stat;
+    if (fd == -1 || fstat(fd, &file_stat) == -1) {
+        printf("Cannot open pack '%s'\n", path);
+        exit(1);
+    }
+    uint64_t index_offset = 0;
+    int number_of_entries = 0;
+    if (file_stat.st_size > 0) {
+        uint8_t footer[PACK_FOOTER_SIZE];
+        if (file_stat.st_size < PACK_FOOTER_SIZE ||
+                pread(fd, footer, PACK_FOOTER_SIZE, file_stat.st_size - PACK_FOOTER_SIZE) != PACK_FOOTER_SIZE) {
+            printf("'%s' is too short to be a dungeon pack\n", path);
+            exit(1);
+        }
+        read_pack_footer(footer, file_stat.st_size, path, &index_offset, &number_of_entries);
+    }
+    long old_index_size = (long) number_of_entries * PACK_ENTRY_SIZE;
+    long index_size = old_index_size + PACK_ENTRY_SIZE;
+    uint8_t * index = malloc(index_size + PACK_FOOTER_SIZE);
+    if (pread(fd, index, old_index_size, index_offset) != old_index_size) {
+        printf("Cannot read the index of '%s'\n", path);
+        exit(1);
+    }
+
+    if (ftruncate(fd, index_offset) == -1 || lseek(fd, index_offset, SEEK_SET) == -1) {
+        printf("Cannot append to pack '%s'\n", path);
+        exit(1);
+    }
+    int saved;
+    if (version == 1) {
+        saved = save_board_version_1(d, fd);
+    }
+    else {
+        saved = save_board_version_0(d, fd);
+    }
+    off_t end = lseek(fd, 0, SEEK_CUR);
+    if (!saved || end == -1) {
+        printf("Cannot append to pack '%s'\n", path);
+        exit(1);
+    }
+
+    int open_cells = 0;
+    for (int i = 0; i < d->width * d->height; i++) {
+        if (d->board.hardness[i] == 0) {
+            open_cells ++;
+        }
+    }
+    uint8_t * fields = index + old_index_size;
+    put_big_endian(fields, index_offset, 8);
+    put_big_endian(fields + 8, end - index_offset, 4);
+    put_big_endian(fields + 12, d->number_of_rooms, 2);
+    put_big_endian(fields + 14, open_cells, 4);
+    put_big_endian(fields + 18, seed, 8);
+    uint8_t * footer = index + index_size;
+    put_big_endian(footer, end, 8);
+    put_big_endian(footer + 8, number_of_entries + 1, 4);
+    memcpy(footer + 12, PACK_FILE_MARKER, DUNGEON_MARKER_SIZE);
+    if (write(fd, index, index_size) != index_size || fsync(fd) == -1 ||
+            write(fd, footer, PACK_FOOTER_SIZE) != PACK_FOOTER_SIZE || fsync(fd) == -1) {
+        printf("Cannot append to pack '%s'\n", path);
+        exit(1);
+    }
+    free(index);
+    close(fd);
+    return number_of_entries;
+}
@@ -0,0 +1,284 @@
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sched.h>
+#include <pthread.h>
+
+#include "dungeon.h"
+
+// Cells a thread takes from a level at a time.
+#define CELLS_PER_CLAIM 64
+// Cells a thread collects for a bucket before adding them to it.
+#define STAGED_CELLS 256
+// Tunneling steps weigh 1 to MAX_TUNNELING_WEIGHT, so the levels being
+// filled while one is relaxed are all in the next MAX_TUNNELING_WEIGHT.
+#define PATH_BUCKETS (MAX_TUNNELING_WEIGHT + 1)
+#define SPINS_BEFORE_YIELD 64
+
+enum Path_Map {
+    MAP_TUNNELING,
+    MAP_NON_TUNNELING
+};
+
+// Threads computing a distance map together, one distance level at a time.
+// Every cell at the current level is final, since steps weigh at least 1.
+// The threads relax those cells in parallel, lowering neighbors with an
+// atomic minimum and adding every cell they lower to the bucket of its new
+// distance, and then meet before the next level. Shortest distances are
+// unique, so the map is the same as the sequential one whatever order the
+// cells are relaxed in.
+struct Path_Pool {
+    pthread_t * threads;
+    // Including the thread that asked for the map.
+    int number_of_threads;
+    pthread_mutex_t lock;
+    pthread_cond_t work_ready;
+    long round;
+    int stopping;
+    Dungeon * d;
+    enum Path_Map map;
+    // Each bucket holds the cells lowered to one of the next few levels,
+    // and never holds a cell twice, so it needs room for every cell.
+    int * buckets[PATH_BUCKETS];
+    int bucket_lengths[PATH_BUCKETS];
+    // The thread that asked for the map relaxes levels as this worker.
+    struct Path_Worker * leader;
+    uint32_t level;
+    int done;
+    int next_cell;
+    int arrived;
+    int sense;
+};
+
+struct Path_Worker {
+    struct Path_Pool * pool;
+    int sense;
+    int staged_lengths[PATH_BUCKETS];
+    int staged[PATH_BUCKETS][STAGED_CELLS];
+};
+
+// Blocks until every thread of the pool has arrived. Levels are short, so
+// threads spin a little before yielding rather than sleep.
+static void wait_for_path_threads(struct Path_Worker * worker) {
+    struct Path_Pool * pool = worker->pool;
+    worker->sense = !worker->sense;
+    if (__atomic_add_fetch(&pool->arrived, 1, __ATOMIC_ACQ_REL) == pool->number_of_threads) {
+        __atomic_store_n(&pool->arrived, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&pool->sense, worker->sense, __ATOMIC_RELEASE);
+        return;
+    }
+    int spins = 0;
+    while (__atomic_load_n(&pool->sense, __ATOMIC_ACQUIRE) != worker->sense) {
+        spins ++;
+        if (spins >= SPINS_BEFORE_YIELD) {
+            sched_yield();
+            spins = 0;
+        }
+    }
+}
+
+static void flush_staged_cells(struct Path_Worker * worker, int bucket) {
+    struct Path_Pool * pool = worker->pool;
+    int length = worker->staged_lengths[bucket];
+    if (!length) {
+        return;
+    }
+    int first = __atomic_fetch_add(&pool->bucket_lengths[bucket], length, __ATOMIC_RELAXED);
+    memcpy(pool->buckets[bucket] + first, worker->staged[bucket], sizeof(int) * length);
+    worker->staged_lengths[bucket] = 0;
+}
+
+static void stage_cell(struct Path_Worker * worker, int bucket, int index) {
+    worker->staged[bucket][worker->staged_lengths[bucket]] = index;
+    worker->staged_lengths[bucket] ++;
+    if (worker->staged_lengths[bucket] == STAGED_CELLS) {
+        flush_staged_cells(worker, bucket);
+    }
+}
+
+// Lowers distances[index] to distance if that is lower, returning 1 if it
+// was.
+static int lower_distance(uint32_t * distances, int index, uint32_t distance) {
+    uint32_t current = __atomic_load_n(&distances[index], __ATOMIC_RELAXED);
+    while (distance < current) {
+        if (__atomic_compare_exchange_n(&distances[index], &current, distance, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Relaxes this thread's share of the cells at the current level.
+static void relax_level(struct Path_Worker * worker) {
+    struct Path_Pool * pool = worker->pool;
+    Dungeon * d = pool->d;
+    uint32_t level = pool->level;
+    int bucket = level % PATH_BUCKETS;
+    int length = pool->bucket_lengths[bucket];
+    const int * cells = pool->buckets[bucket];
+    int tunneling = pool->map == MAP_TUNNELING;
+    // What should_add_tunneling_neighbor and
+    // should_add_non_tunneling_neighbor check, without a call per neighbor.
+    int passable_below = tunneling ? IMMUTABLE_ROCK : 1;
+    const uint8_t * hardness = d->board.hardness;
+    uint32_t * distances = tunneling ? d->board.tunneling_distance : d->board.non_tunneling_distance;
+    while (1) {
+        int first = __atomic_fetch_add(&pool->next_cell, CELLS_PER_CLAIM, __ATOMIC_RELAXED);
+        if (first >= length) {
+            break;
+        }
+        int last = first + CELLS_PER_CLAIM < length ? first + CELLS_PER_CLAIM : length;
+        for (int i = first; i < last; i++) {
+            int index = cells[i];
+            // A cell lowered again after it was added is relaxed from the
+            // lower level instead.
+            if (__atomic_load_n(&distances[index], __ATOMIC_RELAXED) != level) {
+                continue;
+            }
+            uint32_t distance = level + (tunneling ? get_cell_weight(hardness[index]) : 1);
+            for (int n = 0; n < 8; n++) {
+                int neighbor = index + d->neighbor_offsets[n];
+                if (hardness[neighbor] < passable_below && lower_distance(distances, neighbor, distance)) {
+                    stage_cell(worker, distance % PATH_BUCKETS, neighbor);
+                }
+            }
+        }
+    }
+    for (int i = 0; i < PATH_BUCKETS; i++) {
+        flush_staged_cells(worker, i);
+    }
+}
+
+// Every thread of the pool runs the levels in step. After each level one
+// thread empties its bucket and picks the next level holding any cells.
+static void run_path_levels(struct Path_Worker * worker, int leader) {
+    struct Path_Pool * pool = worker->pool;
+    while (1) {
+        relax_level(worker);
+        wait_for_path_threads(worker);
+        if (leader) {
+            pool->bucket_lengths[pool->level % PATH_BUCKETS] = 0;
+            pool->next_cell = 0;
+            pool->done = 1;
+            for (uint32_t level = pool->level + 1; level <= pool->level + MAX_TUNNELING_WEIGHT; level++) {
+                if (pool->bucket_lengths[level % PATH_BUCKETS]) {
+                    pool->level = level;
+                    pool->done = 0;
+                    break;
+                }
+            }
+        }
+        wait_for_path_threads(worker);
+        if (pool->done) {
+            return;
+        }
+    }
+}
+
+void * run_path_worker(void * arg) {
+    struct Path_Worker * worker = arg;
+    struct Path_Pool * pool = worker->pool;
+    long round = 0;
+    while (1) {
+        pthread_mutex_lock(&pool->lock);
+        while (pool->round == round && !pool->stopping) {
+            pthread_cond_wait(&pool->work_ready, &pool->lock);
+        }
+        round = pool->round;
+        int stopping = pool->stopping;
+        pthread_mutex_unlock(&pool->lock);
+        if (stopping) {
+            break;
+        }
+        run_path_levels(worker, 0);
+    }
+    free(worker);
+    return NULL;
+}
+
+struct Path_Worker * create_path_worker(struct Path_Pool * pool) {
+    struct Path_Worker * worker = malloc(sizeof(struct Path_Worker));
+    memset(worker, 0, sizeof(struct Path_Worker));
+    worker->pool = pool;
+    return worker;
+}
+
+// Starts path_threads - 1 workers; the thread asking for a map is the last.
+struct Path_Pool * create_path_pool(Dungeon * d) {
+    struct Path_Pool * pool = malloc(sizeof(struct Path_Pool));
+    memset(pool, 0, sizeof(struct Path_Pool));
+    pool->d = d;
+    pool->number_of_threads = d->path_threads;
+    pool->threads = malloc(sizeof(pthread_t) * (pool->number_of_threads - 1));
+    for (int i = 0; i < PATH_BUCKETS; i++) {
+        pool->buckets[i] = malloc(sizeof(int) * d->width * d->height);
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work_ready, NULL);
+    pool->leader = create_path_worker(pool);
+    for (int i = 0; i < pool->number_of_threads - 1; i++) {
+        struct Path_Worker * worker = create_path_worker(pool);
+        if (pthread_create(&pool->threads[i], NULL, run_path_worker, worker)) {
+            printf("Cannot start path thread %d\n", i);
+            exit(1);
+        }
+    }
+    return pool;
+}
+
+void free_path_pool(struct Path_Pool * pool) {
+    pthread_mutex_lock(&pool->lock);
+    pool->stopping = 1;
+    pthread_cond_broadcast(&pool->work_ready);
+    pthread_mutex_unlock(&pool->lock);
+    for (int i = 0; i < pool->number_of_threads - 1; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->work_ready);
+    for (int i = 0; i < PATH_BUCKETS; i++) {
+        free(pool->buckets[i]);
+    }
+    free(pool->leader);
+    free(pool->threads);
+    free(pool);
+}
+
+// Fills one distance map from the player on the path pool, making the pool
+// on first use.
+static void set_distance_in_parallel(Dungeon * d, enum Path_Map map) {
+    if (d->path_pool == NULL) {
+        d->path_pool = create_path_pool(d);
+    }
+    struct Path_Pool * pool = d->path_pool;
+    uint32_t * distances = map == MAP_TUNNELING ? d->board.tunneling_distance : d->board.non_tunneling_distance;
+    int player_index = cell_index(d, d->player.x, d->player.y);
+    for (int i = 0; i < d->width * d->height; i++) {
+        distances[i] = UNREACHABLE_TUNNELING;
+    }
+    if (map == MAP_NON_TUNNELING && d->board.hardness[player_index] != 0) {
+        return;
+    }
+    distances[player_index] = 0;
+    memset(pool->bucket_lengths, 0, sizeof(pool->bucket_lengths));
+    pool->buckets[0][0] = player_index;
+    pool->bucket_lengths[0] = 1;
+    pool->level = 0;
+    pool->next_cell = 0;
+    pool->map = map;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->round ++;
+    pthread_cond_broadcast(&pool->work_ready);
+    pthread_mutex_unlock(&pool->lock);
+    run_path_levels(pool->leader, 1);
+}
+
+void set_tunneling_distance_in_parallel(Dungeon * d) {
+    set_distance_in_parallel(d, MAP_TUNNELING);
+}
+
+void set_non_tunneling_distance_in_parallel(Dungeon * d) {
+    set_distance_in_parallel(d, MAP_NON_TUNNELING);
+}
@@ -1,102 +1,110 @@
 #include <stdlib.h>
-#include <math.h>
+#include <string.h>
 #include <stdint.h>
 
-struct Coordinate {
-    uint8_t x;
-    uint8_t y;
-};
+#include "priority_queue.h"
 
-typedef struct {
-    int distance;
-    int priority;
-    struct Coordinate coord;
-} Node;
+/*
+ * Binary min-heap ordered on priority. The index maps a coordinate to its
+ * slot in the heap so decrease_priority does not have to search for it.
+ */
 
-typedef struct {
-    int length;
-    Node * nodes;
-} Queue;
+static int coord_key(Queue *q, struct Coordinate coord) {
+    return (coord.y * q->width) + coord.x;
+}
+
+static void set_node(Queue *q, int slot, Node node) {
+    q->nodes[slot] = node;
+    q->index[coord_key(q, node.coord)] = slot;
+}
+
+static void sift_up(Queue *q, int slot) {
+    Node node = q->nodes[slot];
+    while (slot > 0) {
+        int parent = (slot - 1) / 2;
+        if (q->nodes[parent].priority <= node.priority) {
+            break;
+        }
+        set_node(q, slot, q->nodes[parent]);
+        slot = parent;
+    }
+    set_node(q, slot, node);
+}
+
+static void sift_down(Queue *q, int slot) {
+    Node node = q->nodes[slot];
+    while (1) {
+        int child = (slot * 2) + 1;
+        if (child >= q->length) {
+            break;
+        }
+        if (child + 1 < q->length && q->nodes[child + 1].priority < q->nodes[child].priority) {
+            child ++;
+        }
+        if (node.priority <= q->nodes[child].priority) {
+            break;
+        }
+        set_node(q, slot, q->nodes[child]);
+        slot = child;
+    }
+    set_node(q, slot, node);
+}
 
-Queue *create_new_queue(int max_size) {
+// Holds every coordinate of a width by height map.
+Queue *create_new_queue(int width, int height) {
    Queue *q = malloc(sizeof(Queue));
    q->length = 0;
-   q->nodes = malloc(sizeof(Node) * max_size);
+   q->width = width;
+   q->nodes = malloc(sizeof(Node) * width * height);
+   q->index = malloc(sizeof(int) * width * height);
+   memset(q->index, -1, sizeof(int) * width * height);
    return q;
 }
 
+void free_queue(Queue *q) {
+    free(q->nodes);
+    free(q->index);
+    free(q);
+}
+
+// Empties the queue so it can be reused without reallocating it.
+void clear_queue(Queue *q) {
+    for (int i = 0; i < q->length; i++) {
+        q->index[coord_key(q, q->nodes[i].coord)] = -1;
+    }
+    q->length = 0;
+}
+
 void insert_with_priority(Queue *q, struct Coordinate coord, int priority) {
     Node node;
+    node.distance = 0;
     node.coord = coord;
     node.priority = priority;
-    if (q->length == 0) {
-        q->nodes[0] = node;
-        q->length ++;
-        return;
-    }
-    int i;
-    int added = 0;
-    for (i = 0; i < q->length; i++) {
-        Node existing_node = q->nodes[i];
-        if (priority <= existing_node.priority) {
-            for (int j = q->length; j >= i; j--) {
-                Node node_to_shift = q->nodes[j];
-                q->nodes[j+1] = node_to_shift;
-            }
-            q->nodes[i] = node;
-            added = 1;
-            break;
-        }
-    }
-    if (!added) {
-        q->nodes[q->length] = node;
-    }
     q->length ++;
+    q->nodes[q->length - 1] = node;
+    sift_up(q, q->length - 1);
 }
 
 Node extract_min(Queue * q) {
     Node min = q->nodes[0];
-    for(int i = 1; i < q->length; i++) {
-        Node node = q->nodes[i];
-        q->nodes[i-1] = node;
-    }
+    q->index[coord_key(q, min.coord)] = -1;
     q->length --;
+    if (q->length > 0) {
+        q->nodes[0] = q->nodes[q->length];
+        sift_down(q, 0);
+    }
     return min;
 }
 
-int nodes_are_equal(Node node1, Node node2) {
-    return node1.coord.x == node2.coord.x && node1.coord.y == node2.coord.y;
-}
-
 void decrease_priority(Queue *q, struct Coordinate coord, int priority) {
-    Node node;
-    node.coord = coord;
-    node.priority = priority;
-    int old_index;
-    int prev_pri = 0;
-    int found = 0;
-    for (old_index = 0; old_index < q->length; old_index++) {
-       Node existing_node = q->nodes[old_index];
-       if (coord.x == existing_node.coord.x && coord.y == existing_node.coord.y){
-           prev_pri = existing_node.priority;
-           found = 1;
-           break;
-       }
-    }
-    if (!found) {
+    int slot = q->index[coord_key(q, coord)];
+    if (slot < 0 || slot >= q->length) {
         return;
     }
-    int new_index;
-    for (new_index = 0; new_index < q->length; new_index++) {
-        Node existing_node = q->nodes[new_index];
-        if (priority < existing_node.priority) {
-            for (int j = old_index - 1; j >= new_index; j--) {
-                Node node_to_shift = q->nodes[j];
-                q->nodes[j+1] = node_to_shift;
-            }
-            q->nodes[new_index] = node;
-            break;
-        }
+    Node node = q->nodes[slot];
+    if (node.coord.x != coord.x || node.coord.y != coord.y) {
+        return;
     }
-
+    q->nodes[slot].priority = priority;
+    sift_up(q, slot);
 }
@@ -1,6 +1,8 @@
+#include <stdint.h>
+
 struct Coordinate {
-    uint8_t x;
-    uint8_t y;
+    uint16_t x;
+    uint16_t y;
 };
 
 typedef struct {
@@ -11,10 +13,15 @@ typedef struct {
 
 typedef struct {
     int length;
+    int width;
     Node * nodes;
+    // Slot of every coordinate in the heap, or -1 when it is not queued.
+    int * index;
 } Queue;
 
-Queue * create_new_queue(int max_size);
+Queue * create_new_queue(int width, int height);
+void free_queue(Queue * q);
+void clear_queue(Queue * q);
 void insert_with_priority(Queue *q, struct Coordinate coord, int priority);
 Node extract_min(Queue * q);
 void decrease_priority(Queue *q, struct Coordinate coord, int priority);
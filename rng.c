@@ -0,0 +1,36 @@
+#include <stdint.h>
+
+#include "rng.h"
+
+#define PCG_MULTIPLIER 6364136223846793005ULL
+
+void seed_rng(Rng *rng, uint64_t seed, uint64_t stream) {
+    rng->state = 0;
+    rng->increment = (stream << 1) | 1;
+    next_random(rng);
+    rng->state += seed;
+    next_random(rng);
+}
+
+uint32_t next_random(Rng *rng) {
+    uint64_t old_state = rng->state;
+    rng->state = (old_state * PCG_MULTIPLIER) + rng->increment;
+    uint32_t xorshifted = ((old_state >> 18) ^ old_state) >> 27;
+    uint32_t rotation = old_state >> 59;
+    return (xorshifted >> rotation) | (xorshifted << ((-rotation) & 31));
+}
+
+// Uniform value in [0, bound) without modulo bias, using Lemire's
+// multiply-and-reject method.
+uint32_t random_below(Rng *rng, uint32_t bound) {
+    uint64_t product = (uint64_t) next_random(rng) * bound;
+    uint32_t low = (uint32_t) product;
+    if (low < bound) {
+        uint32_t threshold = -bound % bound;
+        while (low < threshold) {
+            product = (uint64_t) next_random(rng) * bound;
+            low = (uint32_t) product;
+        }
+    }
+    return product >> 32;
+}
@@ -0,0 +1,12 @@
+#include <stdint.h>
+
+// PCG32 (XSH RR) generator. Generators seeded with the same seed but
+// different streams produce independent sequences.
+typedef struct {
+    uint64_t state;
+    uint64_t increment;
+} Rng;
+
+void seed_rng(Rng *rng, uint64_t seed, uint64_t stream);
+uint32_t next_random(Rng *rng);
+uint32_t random_below(Rng *rng, uint32_t bound);
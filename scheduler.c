@@ -0,0 +1,310 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "scheduler.h"
+
+#define WHEEL_MASK (WHEEL_SIZE - 1)
+#define OVERFLOW_BUCKET (WHEEL_LEVELS * WHEEL_SIZE)
+#define NOT_SCHEDULED -1
+
+static void append_to_bucket(Scheduler *s, int bucket, int entity) {
+    s->buckets[entity] = bucket;
+    s->next[entity] = -1;
+    s->prev[entity] = s->tails[bucket];
+    if (s->tails[bucket] != -1) {
+        s->next[s->tails[bucket]] = entity;
+    }
+    else {
+        s->heads[bucket] = entity;
+    }
+    s->tails[bucket] = entity;
+    if (bucket != OVERFLOW_BUCKET) {
+        int slot = bucket & WHEEL_MASK;
+        s->occupied[bucket >> WHEEL_BITS][slot / 64] |= 1ULL << (slot % 64);
+    }
+}
+
+static void remove_from_bucket(Scheduler *s, int entity) {
+    int bucket = s->buckets[entity];
+    if (s->prev[entity] != -1) {
+        s->next[s->prev[entity]] = s->next[entity];
+    }
+    else {
+        s->heads[bucket] = s->next[entity];
+    }
+    if (s->next[entity] != -1) {
+        s->prev[s->next[entity]] = s->prev[entity];
+    }
+    else {
+        s->tails[bucket] = s->prev[entity];
+    }
+    if (bucket != OVERFLOW_BUCKET && s->heads[bucket] == -1) {
+        int slot = bucket & WHEEL_MASK;
+        s->occupied[bucket >> WHEEL_BITS][slot / 64] &= ~(1ULL << (slot % 64));
+    }
+    s->buckets[entity] = NOT_SCHEDULED;
+}
+
+// The bucket of the finest level whose current block holds tick.
+static int get_bucket_for_tick(Scheduler *s, uint64_t tick) {
+    for (int level = 0; level < WHEEL_LEVELS; level++) {
+        int shift = WHEEL_BITS * (level + 1);
+        if ((tick >> shift) == (s->now >> shift)) {
+            int slot = (tick >> (WHEEL_BITS * level)) & WHEEL_MASK;
+            return (level * WHEEL_SIZE) + slot;
+        }
+    }
+    return OVERFLOW_BUCKET;
+}
+
+static void place(Scheduler *s, int entity) {
+    append_to_bucket(s, get_bucket_for_tick(s, s->ticks[entity]), entity);
+}
+
+// First occupied slot at or after the given one on a level, or -1.
+static int find_occupied_slot(Scheduler *s, int level, int from) {
+    for (int word = from / 64; word < WHEEL_SIZE / 64; word++) {
+        uint64_t bits = s->occupied[level][word];
+        if (word == from / 64) {
+            bits &= ~0ULL << (from % 64);
+        }
+        if (bits) {
+            return (word * 64) + __builtin_ctzll(bits);
+        }
+    }
+    return -1;
+}
+
+// Moves every entity in a bucket down to the finer levels after now has
+// advanced into the block the bucket covers.
+// The bucket is detached first, since overflow entries may land back in it.
+static void cascade(Scheduler *s, int bucket) {
+    int entity = s->heads[bucket];
+    s->heads[bucket] = -1;
+    s->tails[bucket] = -1;
+    if (bucket != OVERFLOW_BUCKET) {
+        int slot = bucket & WHEEL_MASK;
+        s->occupied[bucket >> WHEEL_BITS][slot / 64] &= ~(1ULL << (slot % 64));
+    }
+    while (entity != -1) {
+        int next = s->next[entity];
+        place(s, entity);
+        entity = next;
+    }
+}
+
+// Advances now to the next block holding any turn once level 0 is empty.
+static void advance(Scheduler *s) {
+    for (int level = 1; level < WHEEL_LEVELS; level++) {
+        int shift = WHEEL_BITS * level;
+        int from = ((s->now >> shift) & WHEEL_MASK) + 1;
+        int slot = from < WHEEL_SIZE ? find_occupied_slot(s, level, from) : -1;
+        if (slot != -1) {
+            uint64_t block = s->now >> (shift + WHEEL_BITS);
+            s->now = (block << (shift + WHEEL_BITS)) | ((uint64_t) slot << shift);
+            cascade(s, (level * WHEEL_SIZE) + slot);
+            return;
+        }
+    }
+    uint64_t earliest = UINT64_MAX;
+    for (int entity = s->heads[OVERFLOW_BUCKET]; entity != -1; entity = s->next[entity]) {
+        if (s->ticks[entity] < earliest) {
+            earliest = s->ticks[entity];
+        }
+    }
+    int shift = WHEEL_BITS * WHEEL_LEVELS;
+    s->now = (earliest >> shift) << shift;
+    cascade(s, OVERFLOW_BUCKET);
+}
+
+Scheduler *create_new_scheduler(int num_entities) {
+    Scheduler *s = malloc(sizeof(Scheduler));
+    s->now = 0;
+    s->length = 0;
+    s->num_entities = num_entities;
+    s->ticks = malloc(sizeof(uint64_t) * num_entities);
+    s->buckets = malloc(sizeof(int) * num_entities);
+    s->next = malloc(sizeof(int) * num_entities);
+    s->prev = malloc(sizeof(int) * num_entities);
+    for (int i = 0; i < num_entities; i++) {
+        s->buckets[i] = NOT_SCHEDULED;
+    }
+    memset(s->heads, -1, sizeof(s->heads));
+    memset(s->tails, -1, sizeof(s->tails));
+    memset(s->occupied, 0, sizeof(s->occupied));
+    return s;
+}
+
+void free_scheduler(Scheduler *s) {
+    free(s->ticks);
+    free(s->buckets);
+    free(s->next);
+    free(s->prev);
+    free(s);
+}
+
+void schedule_turn(Scheduler *s, int entity, uint64_t tick) {
+    if (s->buckets[entity] != NOT_SCHEDULED) {
+        cancel_turn(s, entity);
+    }
+    if (tick < s->now) {
+        tick = s->now;
+    }
+    s->ticks[entity] = tick;
+    place(s, entity);
+    s->length ++;
+}
+
+int turn_is_scheduled(Scheduler *s, int entity) {
+    return s->buckets[entity] != NOT_SCHEDULED;
+}
+
+void cancel_turn(Scheduler *s, int entity) {
+    if (s->buckets[entity] == NOT_SCHEDULED) {
+        return;
+    }
+    remove_from_bucket(s, entity);
+    s->length --;
+}
+
+// Removes and returns the entity with the earliest turn, storing its tick.
+// Returns -1 when nothing is scheduled.
+int next_turn(Scheduler *s, uint64_t * tick) {
+    if (!s->length) {
+        return -1;
+    }
+    while (1) {
+        int slot = find_occupied_slot(s, 0, s->now & WHEEL_MASK);
+        if (slot != -1) {
+            s->now = (s->now & ~(uint64_t) WHEEL_MASK) | slot;
+            int entity = s->heads[slot];
+            remove_from_bucket(s, entity);
+            s->length --;
+            *tick = s->ticks[entity];
+            return entity;
+        }
+        advance(s);
+    }
+}
+
+// Fills entities with the turns still due on the tick of the last turn
+// next_turn returned, in the order next_turn will return them, without
+// removing any. Returns how many were filled in.
+int get_turns_due_now(Scheduler *s, int * entities, int max_entities) {
+    int count = 0;
+    int entity = s->heads[s->now & WHEEL_MASK];
+    while (entity != -1 && count < max_entities) {
+        entities[count] = entity;
+        count ++;
+        entity = s->next[entity];
+    }
+    return count;
+}
+
+// A snapshot is the scheduler struct followed by its per-entity arrays, in
+// native byte order. Restoring it brings back the wheel exactly, including
+// the order of turns due on the same tick.
+long get_scheduler_snapshot_size(int num_entities) {
+    return sizeof(Scheduler) + ((long) num_entities * (sizeof(uint64_t) + (sizeof(int) * 3)));
+}
+
+void write_scheduler_snapshot(Scheduler *s, uint8_t * out) {
+    // The array pointers mean nothing once restored, so they are left out.
+    Scheduler header = *s;
+    header.ticks = NULL;
+    header.buckets = NULL;
+    header.next = NULL;
+    header.prev = NULL;
+    memcpy(out, &header, sizeof(Scheduler));
+    out += sizeof(Scheduler);
+    memcpy(out, s->ticks, sizeof(uint64_t) * s->num_entities);
+    out += sizeof(uint64_t) * s->num_entities;
+    memcpy(out, s->buckets, sizeof(int) * s->num_entities);
+    out += sizeof(int) * s->num_entities;
+    memcpy(out, s->next, sizeof(int) * s->num_entities);
+    out += sizeof(int) * s->num_entities;
+    memcpy(out, s->prev, sizeof(int) * s->num_entities);
+}
+
+// Checks that a restored wheel is one scheduling turns could have built:
+// every scheduled entity is filed where place() would file it, each bucket
+// is a well-formed list of exactly its entities, the occupied bits match
+// the buckets and length counts them all. Nothing else about a snapshot
+// bounds the links, so they are only followed once known to be in range.
+static int scheduler_is_consistent(Scheduler *s) {
+    if (s->length < 0 || s->length > s->num_entities) {
+        return 0;
+    }
+    int scheduled = 0;
+    for (int entity = 0; entity < s->num_entities; entity++) {
+        if (s->buckets[entity] == NOT_SCHEDULED) {
+            continue;
+        }
+        if (s->ticks[entity] < s->now || s->buckets[entity] != get_bucket_for_tick(s, s->ticks[entity])) {
+            return 0;
+        }
+        scheduled ++;
+    }
+    if (scheduled != s->length) {
+        return 0;
+    }
+    int linked = 0;
+    for (int bucket = 0; bucket <= OVERFLOW_BUCKET; bucket++) {
+        int previous = -1;
+        int entity = s->heads[bucket];
+        while (entity != -1) {
+            // A cycle comes back to an entity through a second predecessor.
+            if (entity < 0 || entity >= s->num_entities || s->buckets[entity] != bucket ||
+                    s->prev[entity] != previous || linked == s->length) {
+                return 0;
+            }
+            linked ++;
+            previous = entity;
+            entity = s->next[entity];
+        }
+        if (s->tails[bucket] != previous) {
+            return 0;
+        }
+        if (bucket != OVERFLOW_BUCKET) {
+            int slot = bucket & WHEEL_MASK;
+            int occupied = (s->occupied[bucket >> WHEEL_BITS][slot / 64] >> (slot % 64)) & 1;
+            if (occupied != (s->heads[bucket] != -1)) {
+                return 0;
+            }
+        }
+    }
+    return linked == s->length;
+}
+
+// Returns NULL when size does not match the entity count in the snapshot or
+// the wheel it holds is not consistent.
+Scheduler * read_scheduler_snapshot(const uint8_t * in, long size) {
+    Scheduler header;
+    if (size < (long) sizeof(Scheduler)) {
+        return NULL;
+    }
+    memcpy(&header, in, sizeof(Scheduler));
+    if (header.num_entities < 0 || get_scheduler_snapshot_size(header.num_entities) != size) {
+        return NULL;
+    }
+    Scheduler *s = create_new_scheduler(header.num_entities);
+    header.ticks = s->ticks;
+    header.buckets = s->buckets;
+    header.next = s->next;
+    header.prev = s->prev;
+    memcpy(s, &header, sizeof(Scheduler));
+    in += sizeof(Scheduler);
+    memcpy(s->ticks, in, sizeof(uint64_t) * s->num_entities);
+    in += sizeof(uint64_t) * s->num_entities;
+    memcpy(s->buckets, in, sizeof(int) * s->num_entities);
+    in += sizeof(int) * s->num_entities;
+    memcpy(s->next, in, sizeof(int) * s->num_entities);
+    in += sizeof(int) * s->num_entities;
+    memcpy(s->prev, in, sizeof(int) * s->num_entities);
+    if (!scheduler_is_consistent(s)) {
+        free_scheduler(s);
+        return NULL;
+    }
+    return s;
+}
@@ -0,0 +1,37 @@
+#include <stdint.h>
+
+#define WHEEL_BITS 8
+#define WHEEL_SIZE (1 << WHEEL_BITS)
+#define WHEEL_LEVELS 3
+
+/*
+ * Turn scheduler keyed by entity id. Pending turns sit in a hierarchical
+ * timing wheel: level 0 holds the turns in the current block of 256 ticks,
+ * level 1 the rest of the current block of 65536 ticks, level 2 the rest of
+ * the current block of 2^24 ticks, and anything further out waits in an
+ * overflow list. Turns due on the same tick come out in the order they were
+ * scheduled.
+ */
+typedef struct {
+    uint64_t now;
+    int length;
+    int num_entities;
+    uint64_t * ticks;
+    int * buckets;
+    int * next;
+    int * prev;
+    int heads[WHEEL_LEVELS * WHEEL_SIZE + 1];
+    int tails[WHEEL_LEVELS * WHEEL_SIZE + 1];
+    uint64_t occupied[WHEEL_LEVELS][WHEEL_SIZE / 64];
+} Scheduler;
+
+Scheduler * create_new_scheduler(int num_entities);
+void free_scheduler(Scheduler * s);
+void schedule_turn(Scheduler *s, int entity, uint64_t tick);
+void cancel_turn(Scheduler *s, int entity);
+int turn_is_scheduled(Scheduler *s, int entity);
+int next_turn(Scheduler *s, uint64_t * tick);
+int get_turns_due_now(Scheduler *s, int * entities, int max_entities);
+long get_scheduler_snapshot_size(int num_entities);
+void write_scheduler_snapshot(Scheduler *s, uint8_t * out);
+Scheduler * read_scheduler_snapshot(const uint8_t * in, long size);
@@ -0,0 +1,344 @@
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <arpa/inet.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+#include "dungeon.h"
+
+#define SNAPSHOT_BYTE_ORDER 0x01020304
+// Cells of the monster plane checked for handles at once on restore.
+#define HANDLE_BLOCK 32
+
+// Everything in a game that is not an array. Written as is, so a snapshot
+// can only be restored on a machine with the same byte order and layout,
+// which byte_order and the sizes checked on restore catch.
+struct Snapshot_State {
+    uint32_t byte_order;
+    uint32_t width;
+    uint32_t height;
+    int32_t player_x;
+    int32_t player_y;
+    int32_t player_is_alive;
+    int32_t player_killed_by;
+    int32_t number_of_rooms;
+    int32_t number_of_monsters;
+    int32_t monster_pool_size;
+    int32_t number_of_free_monster_slots;
+    int64_t turns;
+    int32_t monsters_spawned_by_type[NUMBER_OF_MONSTER_TYPES];
+    int32_t monsters_killed_by_type[NUMBER_OF_MONSTER_TYPES];
+    Rng rng_streams[NUMBER_OF_STREAMS];
+    int64_t scheduler_size;
+};
+
+// A snapshot holds a game mid-play: the header, the state above, the whole
+// board including both distance maps and the occupancy grid, the rooms, the
+// monster pool and the turn scheduler, written with one writev. Returns 1 on
+// success.
+int save_snapshot(Dungeon * d, char * path) {
+    struct Snapshot_State state;
+    memset(&state, 0, sizeof(state));
+    state.byte_order = SNAPSHOT_BYTE_ORDER;
+    state.width = d->width;
+    state.height = d->height;
+    state.player_x = d->player.x;
+    state.player_y = d->player.y;
+    state.player_is_alive = d->player_is_alive;
+    state.player_killed_by = d->player_killed_by;
+    state.number_of_rooms = d->number_of_rooms;
+    state.number_of_monsters = d->number_of_monsters;
+    state.monster_pool_size = d->monster_pool_size;
+    state.number_of_free_monster_slots = d->number_of_free_monster_slots;
+    state.turns = d->turns;
+    for (int i = 0; i < NUMBER_OF_MONSTER_TYPES; i++) {
+        state.monsters_spawned_by_type[i] = d->monsters_spawned_by_type[i];
+        state.monsters_killed_by_type[i] = d->monsters_killed_by_type[i];
+    }
+    memcpy(state.rng_streams, d->rng_streams, sizeof(state.rng_streams));
+    state.scheduler_size = get_scheduler_snapshot_size(d->turn_scheduler->num_entities);
+    uint8_t * scheduler = malloc(state.scheduler_size);
+    write_scheduler_snapshot(d->turn_scheduler, scheduler);
+
+    long cells = (long) d->width * d->height;
+    struct iovec parts[12];
+    parts[1].iov_base = &state;
+    parts[1].iov_len = sizeof(state);
+    parts[2].iov_base = d->board.hardness;
+    parts[2].iov_len = sizeof(uint8_t) * cells;
+    parts[3].iov_base = d->board.type;
+    parts[3].iov_len = sizeof(uint8_t) * cells;
+    parts[4].iov_base = d->board.tunneling_distance;
+    parts[4].iov_len = sizeof(uint32_t) * cells;
+    parts[5].iov_base = d->board.non_tunneling_distance;
+    parts[5].iov_len = sizeof(uint32_t) * cells;
+    parts[6].iov_base = d->board.monster;
+    parts[6].iov_len = sizeof(Monster_Handle) * cells;
+    parts[7].iov_base = d->rooms;
+    parts[7].iov_len = sizeof(struct Room) * d->number_of_rooms;
+    parts[8].iov_base = d->monsters;
+    parts[8].iov_len = sizeof(struct Monster) * d->monster_pool_size;
+    parts[9].iov_base = d->monster_generations;
+    parts[9].iov_len = sizeof(uint8_t) * d->monster_pool_size;
+    parts[10].iov_base = d->free_monster_slots;
+    parts[10].iov_len = sizeof(int) * d->monster_pool_size;
+    parts[11].iov_base = scheduler;
+    parts[11].iov_len = state.scheduler_size;
+    long file_size = DUNGEON_HEADER_SIZE;
+    for (int i = 1; i < 12; i++) {
+        file_size += parts[i].iov_len;
+    }
+    uint8_t header[DUNGEON_HEADER_SIZE];
+    uint32_t version = htonl(0);
+    uint32_t size_field = htonl(file_size);
+    memcpy(header, SNAPSHOT_FILE_MARKER, DUNGEON_MARKER_SIZE);
+    memcpy(header + DUNGEON_MARKER_SIZE, &version, 4);
+    memcpy(header + DUNGEON_MARKER_SIZE + 4, &size_field, 4);
+    parts[0].iov_base = header;
+    parts[0].iov_len = DUNGEON_HEADER_SIZE;
+
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    int saved = fd != -1 && writev(fd, parts, 12) == file_size;
+    if (fd != -1) {
+        close(fd);
+    }
+    free(scheduler);
+    return saved;
+}
+
+// Reads a whole snapshot into memory and checks its header. The snapshot
+// can then be restored into as many dungeons as needed.
+Snapshot * read_snapshot(char * path) {
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        printf("Cannot open snapshot '%s'\n", path);
+        exit(1);
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) == -1 || file_stat.st_size < DUNGEON_HEADER_SIZE) {
+        printf("'%s' is too short to be a snapshot\n", path);
+        exit(1);
+    }
+    Snapshot * s = malloc(sizeof(Snapshot));
+    s->path = path;
+    s->size = file_stat.st_size;
+    s->bytes = malloc(s->size);
+    if (read(fd, s->bytes, s->size) != s->size) {
+        printf("Cannot read '%s'\n", path);
+        exit(1);
+    }
+    close(fd);
+
+    uint32_t version;
+    uint32_t file_size;
+    memcpy(&version, s->bytes + DUNGEON_MARKER_SIZE, 4);
+    memcpy(&file_size, s->bytes + DUNGEON_MARKER_SIZE + 4, 4);
+    if (memcmp(s->bytes, SNAPSHOT_FILE_MARKER, DUNGEON_MARKER_SIZE) != 0) {
+        printf("'%s' is not an RLG327 snapshot\n", path);
+        exit(1);
+    }
+    if (ntohl(version) != 0) {
+        printf("Unsupported snapshot version %u\n", ntohl(version));
+        exit(1);
+    }
+    if (ntohl(file_size) != s->size) {
+        printf("Snapshot header says %u bytes but '%s' is %ld bytes\n", ntohl(file_size), path, s->size);
+        exit(1);
+    }
+    return s;
+}
+
+void free_snapshot(Snapshot * s) {
+    free(s->bytes);
+    free(s);
+}
+
+// Copies the next size bytes of a snapshot into destination, exiting if the
+// snapshot ends first.
+static const uint8_t * take_snapshot_section(Snapshot * s, const uint8_t * from, void * destination, long size) {
+    if (size < 0 || size > (s->bytes + s->size) - from) {
+        printf("'%s' is truncated\n", s->path);
+        exit(1);
+    }
+    memcpy(destination, from, size);
+    return from + size;
+}
+
+static int is_inside_border(Dungeon * d, int x, int y) {
+    return x >= 1 && y >= 1 && x < d->width - 1 && y < d->height - 1;
+}
+
+// Exits unless every value a restored game uses as an index is one play
+// could have left behind. A snapshot is otherwise trusted byte for byte, so
+// a corrupt or hostile one would have play_turn read and write out of
+// bounds.
+static void check_restored_game(Dungeon * d, char * path) {
+    int cells = d->width * d->height;
+    if (!is_inside_border(d, d->player.x, d->player.y) ||
+            d->player_killed_by < -1 || d->player_killed_by >= NUMBER_OF_MONSTER_TYPES) {
+        printf("'%s' has a corrupt player\n", path);
+        exit(1);
+    }
+    // Types are 0 to 2. Eight at a time, a type is out of range if it has a
+    // bit above the lowest two or both of them set.
+    uint64_t bad_types = 0;
+    int index = 0;
+    for (; index + 8 <= cells; index += 8) {
+        uint64_t types;
+        memcpy(&types, d->board.type + index, 8);
+        bad_types |= (types & 0xfcfcfcfcfcfcfcfcULL) | (types & (types >> 1) & 0x0101010101010101ULL);
+    }
+    for (; index < cells; index++) {
+        bad_types |= d->board.type[index] > TYPE_CORRIDOR;
+    }
+    // The neighbor loops rely on the outer ring being immutable rock.
+    int border_is_rock = 1;
+    for (int x = 0; x < d->width; x++) {
+        border_is_rock &= d->board.hardness[cell_index(d, x, 0)] == IMMUTABLE_ROCK;
+        border_is_rock &= d->board.hardness[cell_index(d, x, d->height - 1)] == IMMUTABLE_ROCK;
+    }
+    for (int y = 0; y < d->height; y++) {
+        border_is_rock &= d->board.hardness[cell_index(d, 0, y)] == IMMUTABLE_ROCK;
+        border_is_rock &= d->board.hardness[cell_index(d, d->width - 1, y)] == IMMUTABLE_ROCK;
+    }
+    if (bad_types || !border_is_rock) {
+        printf("'%s' has a corrupt board\n", path);
+        exit(1);
+    }
+    for (int i = 0; i < d->number_of_rooms; i++) {
+        struct Room room = d->rooms[i];
+        if (!is_inside_border(d, room.start_x, room.start_y) || !is_inside_border(d, room.end_x, room.end_y) ||
+                room.start_x > room.end_x || room.start_y > room.end_y) {
+            printf("Room %d of '%s' is not inside the dungeon\n", i, path);
+            exit(1);
+        }
+    }
+
+    // Every slot is live unless it is on the free list, once.
+    uint8_t * live = malloc(d->monster_pool_size);
+    memset(live, 1, d->monster_pool_size);
+    for (int i = 0; i < d->number_of_free_monster_slots; i++) {
+        int slot = d->free_monster_slots[i];
+        if (slot < 0 || slot >= d->monster_pool_size || !live[slot]) {
+            printf("'%s' has a corrupt list of free monster slots\n", path);
+            exit(1);
+        }
+        live[slot] = 0;
+    }
+    for (int i = 0; i < d->monster_pool_size; i++) {
+        if (!live[i]) {
+            if (turn_is_scheduled(d->turn_scheduler, i + 1)) {
+                printf("'%s' schedules a turn for dead monster %d\n", path, i);
+                exit(1);
+            }
+            continue;
+        }
+        struct Monster m = d->monsters[i];
+        struct Coordinate known = m.last_known_player_location;
+        if (!is_inside_border(d, m.x, m.y) || m.decimal_type >= NUMBER_OF_MONSTER_TYPES || m.speed == 0 ||
+                d->monster_generations[i] == 0 || known.x >= d->width || known.y >= d->height ||
+                d->board.monster[cell_index(d, m.x, m.y)] != get_monster_handle(d, i)) {
+            printf("'%s' has a corrupt monster in slot %d\n", path, i);
+            exit(1);
+        }
+    }
+    // Each live monster's handle is on its own cell, and handles are
+    // distinct, so the board holds no other handle if it holds no more
+    // handles than there are live monsters. Most of the board is empty, so
+    // handles are only counted in blocks of cells that have any.
+    int handles = 0;
+    for (int first = 0; first < cells; first += HANDLE_BLOCK) {
+        Monster_Handle any = NO_MONSTER;
+        if (first + HANDLE_BLOCK <= cells) {
+            for (int i = first; i < first + HANDLE_BLOCK; i++) {
+                any |= d->board.monster[i];
+            }
+            if (any == NO_MONSTER) {
+                continue;
+            }
+        }
+        for (int i = first; i < first + HANDLE_BLOCK && i < cells; i++) {
+            handles += d->board.monster[i] != NO_MONSTER;
+        }
+    }
+    if (handles != d->monster_pool_size - d->number_of_free_monster_slots) {
+        printf("'%s' has a stale monster handle on the board\n", path);
+        exit(1);
+    }
+    free(live);
+}
+
+// Puts a dungeon back in the state it was snapshotted in, ready for
+// play_turn. Nothing is generated or recomputed; the distance maps come
+// straight from the snapshot. Every index in it is checked before the game
+// uses any of them. Anything the dungeon already held is freed.
+void restore_snapshot(Dungeon * d, Snapshot * s) {
+    const uint8_t * from = s->bytes + DUNGEON_HEADER_SIZE;
+    struct Snapshot_State state;
+    from = take_snapshot_section(s, from, &state, sizeof(state));
+    if (state.byte_order != SNAPSHOT_BYTE_ORDER) {
+        printf("'%s' was written on a machine with a different byte order\n", s->path);
+        exit(1);
+    }
+    if (state.number_of_rooms < 1 || state.monster_pool_size < 0 ||
+            state.number_of_monsters < 0 || state.number_of_monsters > state.monster_pool_size ||
+            state.number_of_free_monster_slots != state.monster_pool_size - state.number_of_monsters) {
+        printf("'%s' has inconsistent room or monster counts\n", s->path);
+        exit(1);
+    }
+
+    free(d->rooms);
+    free(d->monsters);
+    free(d->monster_generations);
+    free(d->free_monster_slots);
+    if (d->turn_scheduler) {
+        free_scheduler(d->turn_scheduler);
+    }
+    set_dungeon_size_from_file(d, state.width, state.height, s->path);
+    d->player.x = state.player_x;
+    d->player.y = state.player_y;
+    d->player_is_alive = state.player_is_alive;
+    d->player_killed_by = state.player_killed_by;
+    d->number_of_rooms = state.number_of_rooms;
+    d->number_of_monsters = state.number_of_monsters;
+    d->monster_pool_size = state.monster_pool_size;
+    d->number_of_free_monster_slots = state.number_of_free_monster_slots;
+    d->turns = state.turns;
+    for (int i = 0; i < NUMBER_OF_MONSTER_TYPES; i++) {
+        d->monsters_spawned_by_type[i] = state.monsters_spawned_by_type[i];
+        d->monsters_killed_by_type[i] = state.monsters_killed_by_type[i];
+    }
+    memcpy(d->rng_streams, state.rng_streams, sizeof(state.rng_streams));
+
+    d->rooms = malloc(sizeof(struct Room) * d->number_of_rooms);
+    d->monsters = malloc(sizeof(struct Monster) * d->monster_pool_size);
+    d->monster_generations = malloc(sizeof(uint8_t) * d->monster_pool_size);
+    d->free_monster_slots = malloc(sizeof(int) * d->monster_pool_size);
+    long cells = (long) d->width * d->height;
+    from = take_snapshot_section(s, from, d->board.hardness, sizeof(uint8_t) * cells);
+    from = take_snapshot_section(s, from, d->board.type, sizeof(uint8_t) * cells);
+    from = take_snapshot_section(s, from, d->board.tunneling_distance, sizeof(uint32_t) * cells);
+    from = take_snapshot_section(s, from, d->board.non_tunneling_distance, sizeof(uint32_t) * cells);
+    from = take_snapshot_section(s, from, d->board.monster, sizeof(Monster_Handle) * cells);
+    from = take_snapshot_section(s, from, d->rooms, sizeof(struct Room) * d->number_of_rooms);
+    from = take_snapshot_section(s, from, d->monsters, sizeof(struct Monster) * d->monster_pool_size);
+    from = take_snapshot_section(s, from, d->monster_generations, sizeof(uint8_t) * d->monster_pool_size);
+    from = take_snapshot_section(s, from, d->free_monster_slots, sizeof(int) * d->monster_pool_size);
+    if (state.scheduler_size != (s->bytes + s->size) - from) {
+        printf("'%s' has sections that do not add up to its size\n", s->path);
+        exit(1);
+    }
+    d->turn_scheduler = read_scheduler_snapshot(from, state.scheduler_size);
+    if (d->turn_scheduler == NULL || d->turn_scheduler->num_entities != d->monster_pool_size + 1) {
+        printf("'%s' has a corrupt turn schedule\n", s->path);
+        exit(1);
+    }
+    check_restored_game(d, s->path);
+    update_player_room(d);
+    reset_decided_moves(d);
+    d->frame_is_drawn = 0;
+}
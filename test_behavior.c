@@ -0,0 +1,395 @@
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "dungeon.h"
+
+// Checks every monster type's moves two ways.
+//
+// Traced games: each fills a generated dungeon with monsters of one type and
+// moves them round after round, drawing from the movement stream, and has to
+// make the moves in behavior_traces.txt. The player does not draw; every few
+// rounds it is put in the room of another monster, so monsters see it, lose
+// sight of it and head for where they last saw it. The types the trait
+// kernels were meant to change (CHANGED_TYPES) are traced from the kernels;
+// every other type is traced from the switch on decimal_type they replaced,
+// by a build of this file against the library from before the kernels with
+// SWITCH_BEHAVIOR defined. --record writes the lines for the types its build
+// traces.
+//
+// Changed rules: the changed types are also set up where the old switch
+// broke its traits, with a remembered player location or the player across
+// rock, and have to follow the new rules there.
+
+#define TRACE_SEEDS 3
+#define TRACE_MONSTERS 8
+#define TRACE_ROUNDS 25
+#define ROUNDS_PER_ROOM 5
+#define MAX_TRACE_LINE 512
+#define DEFAULT_TRACE_PATH "behavior_traces.txt"
+// Dungeons each changed rule is set up in. Erratic monsters only follow the
+// rule on about half of them.
+#define RULE_TRIALS 20
+// Moves a telepathic monster makes toward a player across rock.
+#define RULE_MOVES 40
+
+// 11 no longer tunnels, 1 and 9 no longer step into rock, and 5 and 13 now
+// tunnel where they stepped into rock.
+const int CHANGED_TYPES[] = {1, 5, 9, 11, 13};
+
+char * TRACE_LINES[NUMBER_OF_MONSTER_TYPES][TRACE_SEEDS][TRACE_ROUNDS];
+
+int is_changed_type(int type) {
+    for (int i = 0; i < (int) (sizeof(CHANGED_TYPES) / sizeof(CHANGED_TYPES[0])); i++) {
+        if (CHANGED_TYPES[i] == type) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void move_traced_monster(Dungeon * d, int index) {
+#ifdef SWITCH_BEHAVIOR
+    move_monster_at_index(d, index);
+#else
+    move_monster_at_index(d, index, &d->rng_streams[STREAM_MOVEMENT]);
+#endif
+}
+
+// Whether this build traces the type: the switch only the types the kernels
+// kept, the kernels only the ones they changed.
+int is_traced_by_build(int type) {
+#ifdef SWITCH_BEHAVIOR
+    return !is_changed_type(type);
+#else
+    return is_changed_type(type);
+#endif
+}
+
+int monster_is_alive(Dungeon * d, int index) {
+    struct Monster m = d->monsters[index];
+    return d->board.monster[cell_index(d, m.x, m.y)] == get_monster_handle(d, index);
+}
+
+// The room a cell is in, or -1 in a corridor.
+int get_room_of(Dungeon * d, int x, int y) {
+    for (int i = 0; i < d->number_of_rooms; i++) {
+        struct Room room = d->rooms[i];
+        if (x >= room.start_x && x <= room.end_x && y >= room.start_y && y <= room.end_y) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Puts the player on the first free cell of a room, returning 0 if it has
+// none.
+int move_player_to_room(Dungeon * d, int room_index) {
+    struct Room room = d->rooms[room_index];
+    for (int y = room.start_y; y <= room.end_y; y++) {
+        for (int x = room.start_x; x <= room.end_x; x++) {
+            if (d->board.monster[cell_index(d, x, y)] == NO_MONSTER) {
+                d->player.x = x;
+                d->player.y = y;
+                update_player_room(d);
+                set_non_tunneling_distance_to_player(d);
+                set_tunneling_distance_to_player(d);
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+// Puts the player in the room of the first live monster from slot first on
+// that is in a room.
+void move_player_to_monster_room(Dungeon * d, int first) {
+    for (int n = 0; n < d->monster_pool_size; n++) {
+        int index = (first + n) % d->monster_pool_size;
+        int room_index = get_room_of(d, d->monsters[index].x, d->monsters[index].y);
+        if (monster_is_alive(d, index) && room_index != -1 && move_player_to_room(d, room_index)) {
+            return;
+        }
+    }
+}
+
+// Writes the line for one round: the type, seed and round, then where every
+// monster stands after its move, or - once it is dead.
+void write_trace_line(Dungeon * d, int type, int seed, int round, char * line) {
+    int length = snprintf(line, MAX_TRACE_LINE, "%d %d %d", type, seed, round);
+    for (int i = 0; i < d->monster_pool_size; i++) {
+        if (monster_is_alive(d, i)) {
+            length += snprintf(line + length, MAX_TRACE_LINE - length, " %d,%d", d->monsters[i].x, d->monsters[i].y);
+        }
+        else {
+            length += snprintf(line + length, MAX_TRACE_LINE - length, " -");
+        }
+    }
+}
+
+Dungeon * start_test_game(int seed, int number_of_monsters, int type) {
+    Dungeon * d = create_new_dungeon();
+    d->verbose = 0;
+    d->number_of_monsters = number_of_monsters;
+    seed_random_streams(d, seed);
+    generate_dungeon(d);
+    start_game(d);
+    for (int i = 0; i < d->monster_pool_size; i++) {
+        d->monsters[i].decimal_type = type;
+    }
+    return d;
+}
+
+// Plays one traced game, writing each round's line to record or comparing
+// it with the trace, and returns the number of rounds that differ. Once
+// the player is dead nothing moves.
+int trace_game(int type, int seed, FILE * record) {
+    Dungeon * d = start_test_game(seed, TRACE_MONSTERS, type);
+    int mismatches = 0;
+    char line[MAX_TRACE_LINE];
+    for (int round = 0; round < TRACE_ROUNDS; round++) {
+        if (round && round % ROUNDS_PER_ROOM == 0 && d->player_is_alive) {
+            move_player_to_monster_room(d, round / ROUNDS_PER_ROOM);
+        }
+        for (int i = 0; i < d->monster_pool_size && d->player_is_alive; i++) {
+            if (monster_is_alive(d, i)) {
+                move_traced_monster(d, i);
+            }
+        }
+        write_trace_line(d, type, seed, round, line);
+        if (record != NULL) {
+            fprintf(record, "%s\n", line);
+            continue;
+        }
+        char * expected = TRACE_LINES[type][seed - 1][round];
+        if (expected == NULL || strcmp(line, expected) != 0) {
+            if (!mismatches) {
+                printf("Type %d, seed %d, round %d moved to\n  %s\nbut the trace has\n  %s\n",
+                        type, seed, round, line, expected == NULL ? "nothing" : expected);
+            }
+            mismatches ++;
+        }
+    }
+    free_dungeon(d);
+    return mismatches;
+}
+
+// Reads every line of the trace into TRACE_LINES by its type, seed and
+// round, skipping comments.
+void read_trace(char * path) {
+    FILE * trace = fopen(path, "r");
+    if (trace == NULL) {
+        printf("Cannot open '%s'\n", path);
+        exit(1);
+    }
+    char line[MAX_TRACE_LINE];
+    while (fgets(line, sizeof(line), trace) != NULL) {
+        line[strcspn(line, "\n")] = '\0';
+        if (line[0] == '#' || line[0] == '\0') {
+            continue;
+        }
+        int type, seed, round;
+        if (sscanf(line, "%d %d %d", &type, &seed, &round) != 3 || type < 0 || type >= NUMBER_OF_MONSTER_TYPES ||
+                seed < 1 || seed > TRACE_SEEDS || round < 0 || round >= TRACE_ROUNDS) {
+            printf("'%s' has a line that is not a traced round: %s\n", path, line);
+            exit(1);
+        }
+        free(TRACE_LINES[type][seed - 1][round]);
+        TRACE_LINES[type][seed - 1][round] = strdup(line);
+    }
+    fclose(trace);
+}
+
+// The changed rules only hold for the kernels.
+#ifndef SWITCH_BEHAVIOR
+
+// Moves monster 0 to a cell.
+void put_monster_at(Dungeon * d, int x, int y) {
+    struct Monster * m = &d->monsters[0];
+    d->board.monster[cell_index(d, m->x, m->y)] = NO_MONSTER;
+    m->x = x;
+    m->y = y;
+    d->board.monster[cell_index(d, x, y)] = get_monster_handle(d, 0);
+}
+
+// Sets up monster 0 on the west edge of a room, remembering a player two
+// cells west of it, so its straight step toward that spot is into rock a
+// tunneling monster can wear down. The player is in another room, out of
+// sight. Returns the rock cell, or x = 0 if the dungeon has no such wall.
+struct Coordinate set_up_remembered_player_behind_rock(Dungeon * d) {
+    struct Coordinate rock = {0, 0};
+    for (int i = 0; i < d->number_of_rooms && !rock.x; i++) {
+        struct Room room = d->rooms[i];
+        for (int y = room.start_y; y <= room.end_y && room.start_x >= 3; y++) {
+            int hardness = d->board.hardness[cell_index(d, room.start_x - 1, y)];
+            int other_room = (i + 1) % d->number_of_rooms;
+            if (hardness == 0 || hardness == IMMUTABLE_ROCK ||
+                    d->board.monster[cell_index(d, room.start_x, y)] != NO_MONSTER || !move_player_to_room(d, other_room)) {
+                continue;
+            }
+            put_monster_at(d, room.start_x, y);
+            d->monsters[0].last_known_player_location.x = room.start_x - 2;
+            d->monsters[0].last_known_player_location.y = y;
+            rock.x = room.start_x - 1;
+            rock.y = y;
+            break;
+        }
+    }
+    return rock;
+}
+
+// Sets up monster 0 in the first room and the player in another, so every
+// path between them crosses rock. Returns 0 if the rooms are full.
+int set_up_player_across_rock(Dungeon * d) {
+    struct Room room = d->rooms[0];
+    if (d->board.monster[cell_index(d, room.start_x, room.start_y)] != NO_MONSTER) {
+        return 0;
+    }
+    put_monster_at(d, room.start_x, room.start_y);
+    return move_player_to_room(d, d->number_of_rooms - 1);
+}
+
+// Types 1 and 9 head for the remembered spot without stepping into rock,
+// and never wear it down. Returns the number of failures.
+int check_remembered_spot_without_tunneling(int type) {
+    int stayed = 0;
+    for (int seed = 1; seed <= RULE_TRIALS; seed++) {
+        Dungeon * d = start_test_game(seed, TRACE_MONSTERS, type);
+        struct Coordinate rock = set_up_remembered_player_behind_rock(d);
+        if (!rock.x) {
+            free_dungeon(d);
+            continue;
+        }
+        struct Monster before = d->monsters[0];
+        uint8_t rock_hardness = d->board.hardness[cell_index(d, rock.x, rock.y)];
+        move_traced_monster(d, 0);
+        struct Monster after = d->monsters[0];
+        if (d->board.hardness[cell_index(d, after.x, after.y)] != 0 ||
+                d->board.hardness[cell_index(d, rock.x, rock.y)] != rock_hardness) {
+            printf("Type %d, seed %d stepped into or wore down rock at (%d, %d) heading for (%d, %d)\n",
+                    type, seed, rock.x, rock.y, before.last_known_player_location.x, before.last_known_player_location.y);
+            free_dungeon(d);
+            return 1;
+        }
+        stayed += after.x == before.x && after.y == before.y;
+        free_dungeon(d);
+    }
+    if (!stayed) {
+        printf("Type %d never stayed put in front of rock\n", type);
+        return 1;
+    }
+    return 0;
+}
+
+// Types 5 and 13 tunnel toward the remembered spot. Returns the number of
+// failures.
+int check_remembered_spot_with_tunneling(int type) {
+    int tunneled = 0;
+    for (int seed = 1; seed <= RULE_TRIALS; seed++) {
+        Dungeon * d = start_test_game(seed, TRACE_MONSTERS, type);
+        struct Coordinate rock = set_up_remembered_player_behind_rock(d);
+        if (!rock.x) {
+            free_dungeon(d);
+            continue;
+        }
+        int rock_index = cell_index(d, rock.x, rock.y);
+        uint8_t rock_hardness = d->board.hardness[rock_index];
+        move_traced_monster(d, 0);
+        struct Monster after = d->monsters[0];
+        if (d->board.hardness[cell_index(d, after.x, after.y)] != 0) {
+            printf("Type %d, seed %d stands in rock at (%d, %d)\n", type, seed, after.x, after.y);
+            free_dungeon(d);
+            return 1;
+        }
+        if (d->board.hardness[rock_index] < rock_hardness) {
+            tunneled ++;
+        }
+        else if (!(type & TRAIT_ERRATIC)) {
+            printf("Type %d, seed %d did not tunnel into (%d, %d) toward the remembered player\n", type, seed, rock.x, rock.y);
+            free_dungeon(d);
+            return 1;
+        }
+        free_dungeon(d);
+    }
+    if (!tunneled) {
+        printf("Type %d never tunneled toward the remembered player\n", type);
+        return 1;
+    }
+    return 0;
+}
+
+// Type 11 follows the non-tunneling path to a player across rock and never
+// lowers any hardness. Returns the number of failures.
+int check_telepathic_without_tunneling(int type) {
+    int checked = 0;
+    for (int seed = 1; seed <= RULE_TRIALS; seed++) {
+        Dungeon * d = start_test_game(seed, TRACE_MONSTERS, type);
+        if (!set_up_player_across_rock(d)) {
+            free_dungeon(d);
+            continue;
+        }
+        int cells = d->width * d->height;
+        uint8_t * hardness = malloc(cells);
+        memcpy(hardness, d->board.hardness, cells);
+        for (int move = 0; move < RULE_MOVES && d->player_is_alive && monster_is_alive(d, 0); move++) {
+            move_traced_monster(d, 0);
+            struct Monster m = d->monsters[0];
+            if (memcmp(hardness, d->board.hardness, cells) != 0 || d->board.hardness[cell_index(d, m.x, m.y)] != 0) {
+                printf("Type %d, seed %d tunneled toward the player on move %d\n", type, seed, move);
+                free(hardness);
+                free_dungeon(d);
+                return 1;
+            }
+        }
+        checked ++;
+        free(hardness);
+        free_dungeon(d);
+    }
+    if (!checked) {
+        printf("Type %d was never set up across rock from the player\n", type);
+        return 1;
+    }
+    return 0;
+}
+
+int check_changed_rule(int type) {
+    if (type & TRAIT_TELEPATHIC) {
+        return check_telepathic_without_tunneling(type);
+    }
+    if (type & TRAIT_TUNNELING) {
+        return check_remembered_spot_with_tunneling(type);
+    }
+    return check_remembered_spot_without_tunneling(type);
+}
+
+#endif
+
+int main(int argc, char * argv[]) {
+    if (argc > 1 && !strcmp(argv[1], "--record")) {
+        for (int type = 0; type < NUMBER_OF_MONSTER_TYPES; type++) {
+            for (int seed = 1; seed <= TRACE_SEEDS && is_traced_by_build(type); seed++) {
+                trace_game(type, seed, stdout);
+            }
+        }
+        return 0;
+    }
+#ifdef SWITCH_BEHAVIOR
+    printf("A build with SWITCH_BEHAVIOR can only --record\n");
+    return 1;
+#else
+    read_trace(argc > 1 ? argv[1] : DEFAULT_TRACE_PATH);
+    int failed = 0;
+    for (int type = 0; type < NUMBER_OF_MONSTER_TYPES; type++) {
+        int mismatches = 0;
+        for (int seed = 1; seed <= TRACE_SEEDS; seed++) {
+            mismatches += trace_game(type, seed, NULL);
+        }
+        int rule_failures = is_changed_type(type) ? check_changed_rule(type) : 0;
+        printf("Type %2d: %s%s\n", type, mismatches ? "FAILED the trace" : "matches the trace",
+                !is_changed_type(type) ? "" : rule_failures ? ", FAILED its changed rule" : ", follows its changed rule");
+        failed |= mismatches || rule_failures;
+    }
+    return failed;
+#endif
+}
@@ -0,0 +1,220 @@
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "dungeon.h"
+
+// Monsters handed to a worker at a time.
+#define DECISIONS_PER_CLAIM 16
+
+// Workers that decide the monster moves due on a tick before their turns
+// come up. The dungeon is only read while they run; every move is still
+// made on its own turn, in schedule order, by play_turn.
+struct Turn_Pool {
+    pthread_t * threads;
+    int number_of_threads;
+    pthread_mutex_t lock;
+    pthread_cond_t work_ready;
+    pthread_cond_t work_done;
+    Dungeon * d;
+    // Room for every monster plus the player.
+    int * due_entities;
+    int * telepath_entities;
+    int * telepath_cells;
+    int * telepath_steps;
+    // The monsters of the current round.
+    int * entities;
+    int number_of_entities;
+    uint64_t tick;
+    int next_entity;
+    int busy_workers;
+    long round;
+    int stopping;
+};
+
+// Decides the move of one monster due on tick, from the generator its turn
+// will roll from, and notes what the move was decided from.
+void decide_move_ahead(Dungeon * d, int entity, uint64_t tick) {
+    int index = entity - 1;
+    Rng rng;
+    seed_turn_rng(d, &rng, tick, entity);
+    record_decided_move(d, index, tick, decide_move_for_monster(d, index, &rng));
+}
+
+// Claims monsters from the current round until there are none left.
+void decide_claimed_moves(struct Turn_Pool * pool) {
+    while (1) {
+        pthread_mutex_lock(&pool->lock);
+        int first = pool->next_entity;
+        pool->next_entity += DECISIONS_PER_CLAIM;
+        pthread_mutex_unlock(&pool->lock);
+        if (first >= pool->number_of_entities) {
+            return;
+        }
+        int last = first + DECISIONS_PER_CLAIM;
+        if (last > pool->number_of_entities) {
+            last = pool->number_of_entities;
+        }
+        for (int i = first; i < last; i++) {
+            decide_move_ahead(pool->d, pool->entities[i], pool->tick);
+        }
+    }
+}
+
+void * run_turn_worker(void * arg) {
+    struct Turn_Pool * pool = arg;
+    long round = 0;
+    pthread_mutex_lock(&pool->lock);
+    while (1) {
+        while (pool->round == round && !pool->stopping) {
+            pthread_cond_wait(&pool->work_ready, &pool->lock);
+        }
+        if (pool->stopping) {
+            break;
+        }
+        round = pool->round;
+        pthread_mutex_unlock(&pool->lock);
+        decide_claimed_moves(pool);
+        pthread_mutex_lock(&pool->lock);
+        pool->busy_workers --;
+        if (!pool->busy_workers) {
+            pthread_cond_signal(&pool->work_done);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+// Starts turn_threads - 1 workers; the thread playing the game is the last.
+struct Turn_Pool * create_turn_pool(Dungeon * d) {
+    struct Turn_Pool * pool = malloc(sizeof(struct Turn_Pool));
+    memset(pool, 0, sizeof(struct Turn_Pool));
+    pool->d = d;
+    pool->number_of_threads = d->turn_threads - 1;
+    pool->threads = malloc(sizeof(pthread_t) * pool->number_of_threads);
+    pool->due_entities = malloc(sizeof(int) * (d->monster_pool_size + 1));
+    pool->telepath_entities = malloc(sizeof(int) * d->monster_pool_size);
+    pool->telepath_cells = malloc(sizeof(int) * d->monster_pool_size);
+    pool->telepath_steps = malloc(sizeof(int) * d->monster_pool_size);
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work_ready, NULL);
+    pthread_cond_init(&pool->work_done, NULL);
+    for (int i = 0; i < pool->number_of_threads; i++) {
+        if (pthread_create(&pool->threads[i], NULL, run_turn_worker, pool)) {
+            printf("Cannot start turn thread %d\n", i);
+            exit(1);
+        }
+    }
+    return pool;
+}
+
+void free_turn_pool(struct Turn_Pool * pool) {
+    pthread_mutex_lock(&pool->lock);
+    pool->stopping = 1;
+    pthread_cond_broadcast(&pool->work_ready);
+    pthread_mutex_unlock(&pool->lock);
+    for (int i = 0; i < pool->number_of_threads; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->work_ready);
+    pthread_cond_destroy(&pool->work_done);
+    free(pool->threads);
+    free(pool->due_entities);
+    free(pool->telepath_entities);
+    free(pool->telepath_cells);
+    free(pool->telepath_steps);
+    free(pool);
+}
+
+// Intelligent telepaths that are not erratic roll nothing and only ever
+// step down a distance map, so all of them due on a tick are stepped at
+// once with get_lowest_neighbors.
+void step_telepaths_ahead(Dungeon * d, struct Turn_Pool * pool, int type, const uint32_t * distances, int count, uint64_t tick) {
+    for (int i = 0; i < count; i++) {
+        struct Monster m = d->monsters[pool->telepath_entities[i] - 1];
+        pool->telepath_cells[i] = cell_index(d, m.x, m.y);
+    }
+    get_lowest_neighbors(d, distances, pool->telepath_cells, pool->telepath_steps, count);
+    for (int i = 0; i < count; i++) {
+        int index = pool->telepath_entities[i] - 1;
+        struct Monster_Move move;
+        move.to = get_cell_for_index(d, pool->telepath_steps[i]);
+        move.last_known_player_location = d->monsters[index].last_known_player_location;
+        move.depends_on = type & TRAIT_TUNNELING ? DEPENDS_ON_TUNNELING_MAP : DEPENDS_ON_NON_TUNNELING_MAP;
+        if (d->check_behavior) {
+            Rng rng;
+            seed_turn_rng(d, &rng, tick, index + 1);
+            struct Monster_Move expected = decide_monster_move(d, index, &rng);
+            if (expected.to.x != move.to.x || expected.to.y != move.to.y) {
+                printf("Batched step of monster of type %d went to (%d, %d), expected (%d, %d)\n",
+                        type, move.to.x, move.to.y, expected.to.x, expected.to.y);
+                exit(1);
+            }
+        }
+        record_decided_move(d, index, tick, move);
+    }
+}
+
+// Called on the turn of the first monster due on tick. Decides its move
+// and those of the monsters due after it on the same tick, up to the
+// player's turn, ahead of their turns: intelligent telepaths in batches and
+// the rest on the turn pool. Too few monsters to be worth waking the pool
+// are left to decide on their turns.
+void decide_turns_ahead(Dungeon * d, int entity, uint64_t tick) {
+    if (d->turn_pool == NULL) {
+        d->turn_pool = create_turn_pool(d);
+    }
+    struct Turn_Pool * pool = d->turn_pool;
+    pool->due_entities[0] = entity;
+    int due = 1 + get_turns_due_now(d->turn_scheduler, pool->due_entities + 1, d->monster_pool_size);
+    int monsters = 0;
+    while (monsters < due && pool->due_entities[monsters] != PLAYER_ENTITY) {
+        monsters ++;
+    }
+    d->decided_tick = tick;
+    if (monsters < MIN_TURNS_TO_DECIDE_AHEAD) {
+        return;
+    }
+
+    // Telepaths are moved out of the list first, each kind in turn, keeping
+    // the rest for the pool in place.
+    int telepath_types[2] = {TRAIT_INTELLIGENT | TRAIT_TELEPATHIC, TRAIT_INTELLIGENT | TRAIT_TELEPATHIC | TRAIT_TUNNELING};
+    const uint32_t * telepath_distances[2] = {d->board.non_tunneling_distance, d->board.tunneling_distance};
+    for (int kind = 0; kind < 2; kind++) {
+        int telepaths = 0;
+        int others = 0;
+        for (int i = 0; i < monsters; i++) {
+            int due_entity = pool->due_entities[i];
+            if (d->monsters[due_entity - 1].decimal_type == telepath_types[kind]) {
+                pool->telepath_entities[telepaths] = due_entity;
+                telepaths ++;
+            }
+            else {
+                pool->due_entities[others] = due_entity;
+                others ++;
+            }
+        }
+        step_telepaths_ahead(d, pool, telepath_types[kind], telepath_distances[kind], telepaths, tick);
+        monsters = others;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->entities = pool->due_entities;
+    pool->number_of_entities = monsters;
+    pool->tick = tick;
+    pool->next_entity = 0;
+    pool->busy_workers = pool->number_of_threads;
+    pool->round ++;
+    pthread_cond_broadcast(&pool->work_ready);
+    pthread_mutex_unlock(&pool->lock);
+
+    decide_claimed_moves(pool);
+    pthread_mutex_lock(&pool->lock);
+    while (pool->busy_workers) {
+        pthread_cond_wait(&pool->work_done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}